@@ -0,0 +1,83 @@
+//the cost of the coordinates of a frame: converting every pixel position with a division by the zoom in
+//fd_bigfloat_t (what Renderer::mandelbrot did per pixel) vs. generating the columns and rows once per frame
+//(Coordinates) and reading them per pixel.
+
+#include <chrono>
+#include <string>
+
+#include "config.hpp"
+#include "camera.hpp"
+#include "coordinates.hpp"
+#include "printer.hpp"
+
+using namespace fractaldive;
+
+typedef std::chrono::steady_clock bench_clock;
+
+//per pixel, as before
+fd_mandelfloat_t per_pixel(const Config& config, const Camera& camera) {
+	fd_mandelfloat_t sum = 0;
+	for (fd_dim_t y = 0; y < config.height_; ++y) {
+		for (fd_dim_t x = 0; x < config.width_; ++x) {
+#ifndef _FIXEDPOINT
+			fd_bigfloat_t pointr = camera.getOriginR() + camera.getStepR() * x;
+			fd_bigfloat_t pointi = camera.getOriginI() + camera.getStepI() * y;
+#else
+			fd_mandelfloat_t x0 = (x + camera.getOffsetX() + camera.getPanX()) / (camera.getZoom() / 10.0);
+			fd_mandelfloat_t y0 = (y + camera.getOffsetY() + camera.getPanY()) / (camera.getZoom() / 10.0);
+			fd_bigfloat_t pointr = x0 / config.width_;
+			fd_bigfloat_t pointi = y0 / config.height_;
+#endif
+			sum += fd_mandelfloat_t(pointr) + fd_mandelfloat_t(pointi);
+		}
+	}
+	return sum;
+}
+
+//once per frame, as now
+fd_mandelfloat_t per_frame(const Config& config, const Camera& camera, Coordinates& coordinates) {
+	fd_mandelfloat_t sum = 0;
+	coordinates.generate(camera);
+	for (fd_dim_t y = 0; y < config.height_; ++y) {
+		for (fd_dim_t x = 0; x < config.width_; ++x)
+			sum += coordinates.pointr_[x] + coordinates.pointi_[y];
+	}
+	return sum;
+}
+
+template<typename F>
+double measure(const std::string& name, const Config& config, F f) {
+	const double seconds = 1;
+	fd_mandelfloat_t checksum = 0;
+	size_t frames = 0;
+	auto start = bench_clock::now();
+	double elapsed = 0;
+	do {
+		checksum = f();
+		++frames;
+		elapsed = std::chrono::duration<double>(bench_clock::now() - start).count();
+	} while (elapsed < seconds);
+
+	const double micros = elapsed * 1e6 / frames;
+	//the checksums of both variants should be about the same, it also keeps the loops from being optimized away
+	print(name, micros, "us/frame", micros * 1000.0 / config.frameSize_, "ns/pixel, checksum", checksum);
+	return micros;
+}
+
+int main() {
+	Config& config = Config::getInstance();
+	Camera camera(config, config.zoomFactor_);
+	Coordinates coordinates(config.width_, config.height_);
+	//somewhere in the middle of a dive
+	camera.zoomAt(config.width_ / 3, config.height_ / 3, 1e6, true);
+
+	print("Frame:", config.width_, "x", config.height_, "precision", FD_PRECISION);
+	const double before = measure("Per pixel:", config, [&]() {
+		return per_pixel(config, camera);
+	});
+	const double after = measure("Per frame:", config, [&]() {
+		return per_frame(config, camera, coordinates);
+	});
+	print("Speedup:", before / after);
+	return 0;
+}
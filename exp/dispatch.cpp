@@ -0,0 +1,69 @@
+//the latency of dispatching a frame to the thread pool: the time from parallel_for until every task started and until
+//the task group is done, with idle workers sleeping right away (WAIT_PARK) vs. spinning before they sleep (WAIT_SPIN).
+//the gap between dispatches stands for the time between frames.
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+
+#include "threadpool.hpp"
+#include "printer.hpp"
+
+using namespace fractaldive;
+
+typedef std::chrono::steady_clock bench_clock;
+
+constexpr size_t ROUNDS = 2000;
+constexpr size_t SPIN_MICROS = 200;
+
+struct Round {
+	bench_clock::time_point dispatched_;
+	std::vector<bench_clock::time_point> started_;
+
+	void operator()(const size_t& i) {
+		started_[i] = bench_clock::now();
+	}
+};
+
+double micros(const bench_clock::duration& d) {
+	return std::chrono::duration<double, std::micro>(d).count();
+}
+
+void measure(const std::string& name, const WaitPolicy& policy, const size_t& gapMicros) {
+	const size_t threads = std::max<size_t>(ThreadPool::cores(), 2);
+	ThreadPool pool(threads);
+	pool.setWaitPolicy(policy, SPIN_MICROS);
+	Round round;
+	round.started_.resize(threads);
+	std::vector<double> start(ROUNDS);
+	std::vector<double> done(ROUNDS);
+
+	for (size_t r = 0; r < ROUNDS; ++r) {
+		std::this_thread::sleep_for(std::chrono::microseconds(gapMicros));
+		TaskGroup group;
+		round.dispatched_ = bench_clock::now();
+		pool.parallel_for(group, 0, threads, round);
+		group.wait();
+		done[r] = micros(bench_clock::now() - round.dispatched_);
+		start[r] = micros(*std::max_element(round.started_.begin(), round.started_.end()) - round.dispatched_);
+	}
+	pool.stop();
+
+	//medians, the mean is dominated by the odd preemption
+	std::sort(start.begin(), start.end());
+	std::sort(done.begin(), done.end());
+	print(name, "gap", gapMicros, "us: last task started after", start[ROUNDS / 2], "us, group done after", done[ROUNDS / 2], "us");
+}
+
+int main() {
+	print("Threads:", std::max<size_t>(ThreadPool::cores(), 2), "rounds", ROUNDS, "spin", SPIN_MICROS, "us");
+	const size_t gaps[] = { 0, 50, 1000 };
+	for (const size_t& gap : gaps) {
+		measure("park:", WAIT_PARK, gap);
+		measure("spin:", WAIT_SPIN, gap);
+	}
+	return 0;
+}
@@ -0,0 +1,59 @@
+//the throughput of the deep zoom arithmetic: the scalar kernel iterating the same pixels beyond the resolution of
+//double in __float128 (soft-float) vs. the multi-limb fixed point types with 2, 3 and 4 limbs.
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "kernel.hpp"
+#include "printer.hpp"
+
+using namespace fractaldive;
+using namespace mn::MFixedPoint;
+
+typedef std::chrono::steady_clock bench_clock;
+
+constexpr fd_dim_t SIZE = 32;
+constexpr fd_iter_count_t MAX_ITERATIONS = 10000;
+
+//a spiral of seahorse valley, with a pixel spacing of 1e-20
+template<typename T>
+std::vector<T> axis(const double& center) {
+	std::vector<T> points(SIZE);
+	const T step = T(1e-20);
+	for (fd_dim_t i = 0; i < SIZE; ++i)
+		points[i] = T(center) + step * int64_t(i);
+	return points;
+}
+
+template<typename T>
+void measure(const std::string& name) {
+	const std::vector<T> pointr = axis<T>(-0.743643887037158704752191506114774);
+	const std::vector<T> pointi = axis<T>(0.131825904205311970493132056385139);
+	const double seconds = 1;
+	uint64_t iterations = 0;
+	uint64_t checksum = 0;
+	auto start = bench_clock::now();
+	double elapsed = 0;
+	do {
+		checksum = 0;
+		for (fd_dim_t y = 0; y < SIZE; ++y) {
+			for (fd_dim_t x = 0; x < SIZE; ++x)
+				checksum += mandelbrot_point<T>(pointr[x], pointi[y], MAX_ITERATIONS, false);
+		}
+		iterations += checksum;
+		elapsed = std::chrono::duration<double>(bench_clock::now() - start).count();
+	} while (elapsed < seconds);
+
+	//the checksums are the iteration counts of the grid and should be about the same for all types
+	print(name, iterations / elapsed / 1e6, "Mit/s, checksum", checksum);
+}
+
+int main() {
+	print("Grid:", SIZE, "x", SIZE, "max iterations", MAX_ITERATIONS);
+	measure<__float128>("__float128:");
+	measure<FpM8<2>>("FpM 2 limbs:");
+	measure<FpM8<3>>("FpM 3 limbs:");
+	measure<FpM8<4>>("FpM 4 limbs:");
+	return 0;
+}
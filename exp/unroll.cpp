@@ -0,0 +1,59 @@
+//the scalar kernel with the escape check on every iteration (mandelbrot_point) vs. checked only every 2, 4 and 8
+//iterations (mandelbrot_point_unrolled). the checksums must be the same for all unroll factors.
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "kernel.hpp"
+#include "printer.hpp"
+
+using namespace fractaldive;
+
+typedef std::chrono::steady_clock bench_clock;
+
+constexpr fd_dim_t SIZE = 128;
+constexpr fd_iter_count_t MAX_ITERATIONS = 2000;
+
+//around seahorse valley, with a pixel spacing of 1e-5
+std::vector<fd_mandelfloat_t> axis(const double& center) {
+	std::vector<fd_mandelfloat_t> points(SIZE);
+	for (fd_dim_t i = 0; i < SIZE; ++i)
+		points[i] = fd_mandelfloat_t(center + (double(i) - SIZE / 2) * 1e-5);
+	return points;
+}
+
+template<size_t Unroll>
+void measure(const bool& checkInterior) {
+	const std::vector<fd_mandelfloat_t> pointr = axis(-0.743643887);
+	const std::vector<fd_mandelfloat_t> pointi = axis(0.131825904);
+	const double seconds = 1;
+	uint64_t iterations = 0;
+	uint64_t checksum = 0;
+	auto start = bench_clock::now();
+	double elapsed = 0;
+	do {
+		checksum = 0;
+		for (fd_dim_t y = 0; y < SIZE; ++y) {
+			for (fd_dim_t x = 0; x < SIZE; ++x) {
+				checksum += mandelbrot_point_unroll<fd_mandelfloat_t>(Unroll, pointr[x], pointi[y], MAX_ITERATIONS, checkInterior);
+			}
+		}
+		iterations += checksum;
+		elapsed = std::chrono::duration<double>(bench_clock::now() - start).count();
+	} while (elapsed < seconds);
+
+	print("unroll " + std::to_string(Unroll) + ":", iterations / elapsed / 1e6, "Mit/s, checksum", checksum);
+}
+
+int main() {
+	print("Grid:", SIZE, "x", SIZE, "max iterations", MAX_ITERATIONS);
+	for (const bool checkInterior : { false, true }) {
+		print("Interior check:", checkInterior ? "on" : "off");
+		measure<1>(checkInterior);
+		measure<2>(checkInterior);
+		measure<4>(checkInterior);
+		measure<8>(checkInterior);
+	}
+	return 0;
+}
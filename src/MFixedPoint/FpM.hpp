@@ -0,0 +1,414 @@
+///
+/// \file 				FpM.hpp
+/// \brief 				Multi-limb fixed point numbers for deep zooms.
+/// \details
+///		A number consists of numLimbs 64-bit limbs in two's complement (least significant limb first)
+///		with numFracBits fractional bits. Products are calculated exactly with 128-bit partial products
+///		and truncated (rounded towards zero). The results are therefore independent of the FPU and
+///		the compiler flags (-ffast-math).
+
+//===============================================================================================//
+//====================================== HEADER GUARD ===========================================//
+//===============================================================================================//
+
+#ifndef __cplusplus
+    #error Please build with C++ compiler
+#endif
+
+#ifndef MN_MFIXEDPOINT_FpM_H
+#define MN_MFIXEDPOINT_FpM_H
+
+#ifndef __SIZEOF_INT128__
+    #error FpM needs a compiler with 128-bit integers
+#endif
+
+// System includes
+#include <ostream>
+#include <stdint.h>
+#include <string>
+#include <cmath>
+
+namespace mn {
+namespace MFixedPoint {
+
+/// \brief		Represents a fixed point number of numLimbs 64-bit limbs, with the template argument
+///				numFracBits defining the number of fractional bits (and consequentially also the number of
+///				integer bits, including the sign).
+/// \details	Contains the operators needed to iterate fractals (add, subtract, multiply, square and compare)
+///				and the conversions needed to set it up. Doesn't have division by fixed-point numbers.
+template<uint8_t numLimbs, uint16_t numFracBits>
+class FpM {
+    static_assert(numLimbs >= 1, "FpM needs at least one limb.");
+    static_assert(numFracBits < numLimbs * 64, "FpM needs at least one integer bit for the sign.");
+
+    __extension__ typedef unsigned __int128 uint128_t;
+    static constexpr uint16_t NUM_BITS = numLimbs * 64;
+
+public:
+
+    //===============================================================================================//
+    //================================== CONSTRUCTORS/DESTRUCTORS ===================================//
+    //===============================================================================================//
+
+    FpM() = default;
+
+    ~FpM() = default;
+
+    FpM(int32_t i) {
+        FromInt(i);
+    }
+
+    FpM(int64_t i) {
+        FromInt(i);
+    }
+
+    /// \brief		Create a fixed-point number from a double.
+    /// \details	Exact as long as the value fits and has no bits below 2^-numFracBits (truncated otherwise).
+    FpM(double d) {
+        Clear();
+        bool negative = d < 0;
+        int exponent;
+        //d = mantissa * 2^(exponent - 53) with an integral mantissa
+        uint64_t mantissa = (uint64_t) std::ldexp(std::frexp(negative ? -d : d, &exponent), 53);
+        ShiftInto(mantissa, exponent - 53 + numFracBits);
+        if (negative)
+            Negate();
+    }
+
+    FpM(float f) :
+            FpM((double) f) {}
+
+    /// \brief		Calculates 1 / d, exact to the last fractional bit (truncated).
+    /// \details	In contrast to FpM(1.0 / d) the quotient isn't limited to the 53 bits of a double.
+    static FpM Reciprocal(double d) {
+        bool negative = d < 0;
+        int exponent;
+        uint64_t mantissa = (uint64_t) std::ldexp(std::frexp(negative ? -d : d, &exponent), 53);
+        //1 / d = 2^(53 - exponent) / mantissa. the dividend is a single bit which is divided limb by limb
+        //starting from the most significant limb of a 2 * numLimbs wide integer.
+        int bit = 53 - exponent + numFracBits;
+        FpM x;
+        x.Clear();
+        if (bit < 0 || mantissa == 0)
+            return x;
+
+        uint128_t remainder = 0;
+        for (int i = 2 * numLimbs - 1; i >= 0; --i) {
+            remainder = (remainder << 64) | (bit / 64 == i ? (uint64_t) 1 << (bit % 64) : 0);
+            if (i < numLimbs)
+                x.limbs_[i] = (uint64_t) (remainder / mantissa);
+            remainder %= mantissa;
+        }
+        if (negative)
+            x.Negate();
+        return x;
+    }
+
+    //===============================================================================================//
+    //========================================= GETTERS/SETTERS =====================================//
+    //===============================================================================================//
+
+    /// \brief		Get a limb of the raw value (memory representation) of this fixed-point number.
+    uint64_t GetRawLimb(uint8_t i) const {
+        return limbs_[i];
+    }
+
+    bool IsNegative() const {
+        return (int64_t) limbs_[numLimbs - 1] < 0;
+    }
+
+    //===============================================================================================//
+    //================================= COMPOUND ARITHMETIC OVERLOADS ===============================//
+    //===============================================================================================//
+
+    FpM& operator += (const FpM& r) {
+        uint64_t carry = 0;
+        for (uint8_t i = 0; i < numLimbs; ++i) {
+            uint128_t sum = (uint128_t) limbs_[i] + r.limbs_[i] + carry;
+            limbs_[i] = (uint64_t) sum;
+            carry = (uint64_t) (sum >> 64);
+        }
+        return *this;
+    }
+
+    FpM& operator -= (const FpM& r) {
+        uint64_t borrow = 0;
+        for (uint8_t i = 0; i < numLimbs; ++i) {
+            uint128_t difference = (uint128_t) limbs_[i] - r.limbs_[i] - borrow;
+            limbs_[i] = (uint64_t) difference;
+            borrow = (uint64_t) (difference >> 64) & 1;
+        }
+        return *this;
+    }
+
+    /// \brief		Overload for '*=' operator.
+    /// \details	Multiplies the magnitudes into a 2 * numLimbs wide product and keeps the numLimbs limbs above
+    ///				the fractional bits.
+    FpM& operator *= (const FpM& r) {
+        bool negative = IsNegative() != r.IsNegative();
+        FpM a = IsNegative() ? -*this : *this;
+        FpM b = r.IsNegative() ? -r : r;
+        uint64_t product[2 * numLimbs] = { 0 };
+        for (uint8_t i = 0; i < numLimbs; ++i) {
+            uint64_t carry = 0;
+            for (uint8_t j = 0; j < numLimbs; ++j) {
+                uint128_t t = (uint128_t) a.limbs_[i] * b.limbs_[j] + product[i + j] + carry;
+                product[i + j] = (uint64_t) t;
+                carry = (uint64_t) (t >> 64);
+            }
+            product[i + numLimbs] = carry;
+        }
+        ShiftOut(product);
+        if (negative)
+            Negate();
+        return *this;
+    }
+
+    /// \brief		Multiplication by an integer, which may exceed the integer range of the fixed-point number.
+    FpM& operator *= (int64_t r) {
+        bool negative = IsNegative() != (r < 0);
+        if (IsNegative())
+            Negate();
+        uint64_t m = r < 0 ? -(uint64_t) r : (uint64_t) r;
+        uint64_t carry = 0;
+        for (uint8_t i = 0; i < numLimbs; ++i) {
+            uint128_t t = (uint128_t) limbs_[i] * m + carry;
+            limbs_[i] = (uint64_t) t;
+            carry = (uint64_t) (t >> 64);
+        }
+        if (negative)
+            Negate();
+        return *this;
+    }
+
+    /// \brief		Division by an integer. Truncates the quotient.
+    FpM& operator /= (int64_t r) {
+        bool negative = IsNegative() != (r < 0);
+        if (IsNegative())
+            Negate();
+        uint64_t d = r < 0 ? -(uint64_t) r : (uint64_t) r;
+        uint128_t remainder = 0;
+        for (int i = numLimbs - 1; i >= 0; --i) {
+            remainder = (remainder << 64) | limbs_[i];
+            limbs_[i] = (uint64_t) (remainder / d);
+            remainder %= d;
+        }
+        if (negative)
+            Negate();
+        return *this;
+    }
+
+    // Simple Arithmetic Overloads
+
+    /// \brief		Overload for '-itself' operator.
+    FpM operator - () const {
+        FpM x = *this;
+        x.Negate();
+        return x;
+    }
+
+    FpM operator + (const FpM& r) const {
+        FpM x = *this;
+        x += r;
+        return x;
+    }
+
+    FpM operator - (const FpM& r) const {
+        FpM x = *this;
+        x -= r;
+        return x;
+    }
+
+    FpM operator * (const FpM& r) const {
+        FpM x = *this;
+        x *= r;
+        return x;
+    }
+
+    FpM operator * (int64_t r) const {
+        FpM x = *this;
+        x *= r;
+        return x;
+    }
+
+    FpM operator / (int64_t r) const {
+        FpM x = *this;
+        x /= r;
+        return x;
+    }
+
+    /// \brief		Squares the number.
+    /// \details	Cheaper than x * x: the sign doesn't matter and every cross product is only calculated once.
+    FpM Square() const {
+        FpM a = IsNegative() ? -*this : *this;
+        uint64_t product[2 * numLimbs] = { 0 };
+        //cross products a[i] * a[j] with i < j
+        for (uint8_t i = 0; i < numLimbs; ++i) {
+            uint64_t carry = 0;
+            for (uint8_t j = i + 1; j < numLimbs; ++j) {
+                uint128_t t = (uint128_t) a.limbs_[i] * a.limbs_[j] + product[i + j] + carry;
+                product[i + j] = (uint64_t) t;
+                carry = (uint64_t) (t >> 64);
+            }
+            product[i + numLimbs] = carry;
+        }
+        //doubled, plus the squares on the diagonal
+        uint64_t carry = 0;
+        for (uint8_t i = 0; i < numLimbs; ++i) {
+            uint128_t t = (uint128_t) a.limbs_[i] * a.limbs_[i];
+            uint128_t lo = (uint128_t) (product[2 * i] << 1) + (uint64_t) t + carry;
+            uint128_t hi = (uint128_t) (product[2 * i + 1] << 1) + (product[2 * i] >> 63) + (uint64_t) (t >> 64) + (uint64_t) (lo >> 64);
+            carry = (product[2 * i + 1] >> 63) + (uint64_t) (hi >> 64);
+            product[2 * i] = (uint64_t) lo;
+            product[2 * i + 1] = (uint64_t) hi;
+        }
+        FpM x;
+        x.ShiftOut(product);
+        return x;
+    }
+
+    // FpM-FpM Binary Operator Overloads
+
+    bool operator == (const FpM& r) const {
+        for (uint8_t i = 0; i < numLimbs; ++i) {
+            if (limbs_[i] != r.limbs_[i])
+                return false;
+        }
+        return true;
+    }
+
+    bool operator != (const FpM& r) const {
+        return !(*this == r);
+    }
+
+    bool operator < (const FpM& r) const {
+        if (limbs_[numLimbs - 1] != r.limbs_[numLimbs - 1])
+            return (int64_t) limbs_[numLimbs - 1] < (int64_t) r.limbs_[numLimbs - 1];
+        for (int i = numLimbs - 2; i >= 0; --i) {
+            if (limbs_[i] != r.limbs_[i])
+                return limbs_[i] < r.limbs_[i];
+        }
+        return false;
+    }
+
+    bool operator > (const FpM& r) const {
+        return r < *this;
+    }
+
+    bool operator <= (const FpM& r) const {
+        return !(r < *this);
+    }
+
+    bool operator >= (const FpM& r) const {
+        return !(*this < r);
+    }
+
+    /// \defgroup From FpM Conversion Overloads (casts)
+    /// \{
+
+    /// \brief		Converts the fixed-point number to a double.
+    /// \details	Only the 2 most significant limbs that hold bits are taken into account.
+    double ToDouble() const {
+        FpM a = IsNegative() ? -*this : *this;
+        double d = 0;
+        for (int i = numLimbs - 1; i >= 0; --i) {
+            if (a.limbs_[i] != 0) {
+                d = std::ldexp((double) a.limbs_[i], i * 64 - numFracBits);
+                if (i > 0)
+                    d += std::ldexp((double) a.limbs_[i - 1], (i - 1) * 64 - numFracBits);
+                break;
+            }
+        }
+        return IsNegative() ? -d : d;
+    }
+
+    float ToFloat() const {
+        return (float) ToDouble();
+    }
+
+    /// \brief		Conversion operator from fixed-point to double.
+    explicit operator double() const {
+        return ToDouble();
+    }
+
+    /// \}
+
+    //===============================================================================================//
+    //====================================== STRING/STREAM RELATED ==================================//
+    //===============================================================================================//
+
+    std::string ToString() const {
+        return std::to_string(ToDouble());
+    }
+
+    /// \brief      Overload so we can print to a ostream (e.g. std::cout).
+    friend std::ostream &operator<<(std::ostream &stream, const FpM& obj) {
+        stream << obj.ToDouble();
+        return stream;
+    }
+
+private:
+
+    void Clear() {
+        for (uint8_t i = 0; i < numLimbs; ++i)
+            limbs_[i] = 0;
+    }
+
+    template<class IntType>
+    void FromInt(IntType i) {
+        Clear();
+        ShiftInto(i < 0 ? -(uint64_t) i : (uint64_t) i, numFracBits);
+        if (i < 0)
+            Negate();
+    }
+
+    /// \brief		Stores value * 2^shift. Bits shifted below the first limb are dropped.
+    void ShiftInto(uint64_t value, int shift) {
+        if (shift <= -64 || shift >= NUM_BITS)
+            return;
+        if (shift < 0) {
+            limbs_[0] = value >> -shift;
+            return;
+        }
+        uint8_t limb = shift / 64;
+        uint8_t bits = shift % 64;
+        limbs_[limb] = value << bits;
+        if (bits != 0 && limb + 1 < numLimbs)
+            limbs_[limb + 1] = value >> (64 - bits);
+    }
+
+    /// \brief		Stores the limbs of a 2 * numLimbs wide product above its 2 * numFracBits fractional bits.
+    void ShiftOut(const uint64_t* product) {
+        constexpr uint8_t limb = numFracBits / 64;
+        constexpr uint8_t bits = numFracBits % 64;
+        for (uint8_t i = 0; i < numLimbs; ++i) {
+            limbs_[i] = product[i + limb] >> bits;
+            if (bits != 0)
+                limbs_[i] |= product[i + limb + 1] << (64 - bits);
+        }
+    }
+
+    void Negate() {
+        uint64_t carry = 1;
+        for (uint8_t i = 0; i < numLimbs; ++i) {
+            uint128_t sum = (uint128_t) ~limbs_[i] + carry;
+            limbs_[i] = (uint64_t) sum;
+            carry = (uint64_t) (sum >> 64);
+        }
+    }
+
+    /// \brief		The fixed-point number is stored in these limbs, least significant first.
+    uint64_t limbs_[numLimbs];
+};
+
+/// \brief		Multi-limb fixed-point numbers with 8 integer bits (including the sign), which holds every
+///				value of an escape time iteration up to a bailout radius of 2.
+template<uint8_t numLimbs>
+using FpM8 = FpM<numLimbs, numLimbs * 64 - 8>;
+
+} // namespace MFixedPoint
+} //namespace mn
+
+#endif // #ifndef MN_MFIXEDPOINT_FpM_H
+
+// EOF
@@ -22,29 +22,81 @@ std::pair<fd_coord_t, fd_coord_t> Camera::calculatePanVector(const fd_coord_t& x
 	return {panX, panY};
 }
 
+fd_float_t Camera::zoomSpeedFactor() const {
+	return 1.0 + (config_.zoomSpeed_ / config_.fps_);
+}
+
 void Camera::zoom(fd_coord_t atX, fd_coord_t atY) {
 	const auto& pv = calculatePanVector(atX, atY);
-	fd_float_t zoomFactor = 1.0 + (config_.zoomSpeed_ / config_.fps_);
 	pan(pv.first, pv.second);
-	zoomAt(config_.width_ / 2.0, config_.height_ / 2.0, zoomFactor, true);
+	zoomAt(config_.width_ / 2.0, config_.height_ / 2.0, zoomSpeedFactor(), true);
 	++frameCount_;
 }
 
+#ifndef _FIXEDPOINT
+//c moved to the nearest whole number of steps, which keeps the real axis on a row of pixels (see
+//Renderer::prepareSymmetry) as the positions in pixels used to. there is no rounding function for fd_bigfloat_t without
+//libquadmath, so the number of steps is rounded in double, 53 bits at a time.
+static fd_bigfloat_t snap(const fd_bigfloat_t& c, const fd_bigfloat_t& step) {
+	fd_bigfloat_t rest = c / step;
+	fd_bigfloat_t steps = 0;
+	for (size_t i = 0; i < 3; ++i) {
+		const fd_bigfloat_t part = std::round(double(rest));
+		steps += part;
+		rest -= part;
+	}
+	return steps * step;
+}
+
+bool Camera::canZoomIn() const {
+	//the pan before zoomAt() moves the frame by less than a frame, so the next one lies within two frames of pixel (0,0)
+	const fd_bigfloat_t extentr = (originr_ < 0 ? -originr_ : originr_) + getStepR() * config_.width_ * 2;
+	const fd_bigfloat_t extenti = (origini_ < 0 ? -origini_ : origini_) + getStepI() * config_.height_ * 2;
+	const fd_bigfloat_t step = std::min(getStepR(), getStepI()) / zoomSpeedFactor();
+	//the criterion of select_precision() with the 112 bits of the mantissa of fd_bigfloat_t
+	return std::max(extentr, extenti) * std::ldexp(1.0, int(config_.precisionGuardBits_) - 112) < step;
+}
+#else
+bool Camera::canZoomIn() const {
+	//zoomAt() scales the position plus half a frame, the pan before it moves it by less than a frame
+	const fd_float_t limit = std::numeric_limits<fd_coord_t>::max() / zoomSpeedFactor() - 2 * std::max(config_.width_, config_.height_);
+	return std::fabs(fd_float_t(getOriginX())) < limit && std::fabs(fd_float_t(getOriginY())) < limit;
+}
+#endif
+
 // Zoom the fractal
 void Camera::zoomAt(const fd_coord_t& x, const fd_coord_t& y, const fd_float_t& factor, const bool& zoomin) {
+#ifndef _FIXEDPOINT
+	//pixel (x, y) of the frame becomes pixel (-offsetx_, -offsety_) of the zoomed one
+	const fd_bigfloat_t r = originr_ + getStepR() * x;
+	const fd_bigfloat_t i = origini_ + getStepI() * y;
+	if (zoomin) {
+		++zoomCount_;
+		zoom_ *= factor;
+	} else {
+		--zoomCount_;
+		zoom_ /= factor;
+	}
+	originr_ = snap(r + getStepR() * offsetx_, getStepR());
+	origini_ = snap(i + getStepI() * offsety_, getStepI());
+#else
+	//fixed point builds have no wider type that takes fd_coord_t, the position moves in steps beyond a zoom of about
+	//1e14 there
+	typedef fd_float_t scale_t;
 	if (zoomin) {
 		// Zoom in
 		++zoomCount_;
 		zoom_ *= factor;
-		panx_ = factor * (x + offsetx_ + panx_);
-		pany_ = factor * (y + offsety_ + pany_);
+		panx_ = scale_t(factor) * scale_t(x + offsetx_ + panx_);
+		pany_ = scale_t(factor) * scale_t(y + offsety_ + pany_);
 	} else {
 		// Zoom out
 		--zoomCount_;
 		zoom_ /= factor;
-		panx_ = (x + offsetx_ + panx_) / factor;
-		pany_ = (y + offsety_ + pany_) / factor;
+		panx_ = scale_t(x + offsetx_ + panx_) / scale_t(factor);
+		pany_ = scale_t(y + offsety_ + pany_) / scale_t(factor);
 	}
+#endif
 }
 
 void Camera::resetSmoothPan() {
@@ -93,7 +145,12 @@ std::pair<fd_coord_t, fd_coord_t> Camera::smoothPan(const fd_coord_t& x, const f
 // Pan the fractal
 void Camera::pan(const fd_coord_t& x, const fd_coord_t& y) {
 	auto ft = smoothPan(x, y);
+#ifndef _FIXEDPOINT
+	originr_ += getStepR() * ft.first;
+	origini_ += getStepI() * ft.second;
+#else
 	panx_ += ft.first;
 	pany_ += ft.second;
+#endif
 }
 } /* namespace fractaldive */
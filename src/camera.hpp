@@ -7,6 +7,8 @@
 #include <cmath>
 #include <ctime>
 #include <random>
+#include <limits>
+#include <algorithm>
 
 #include "config.hpp"
 
@@ -27,8 +29,18 @@ class Camera {
 	// used for smoothing automatic panning
 	std::deque<fd_coord_t> panHistoryX_;
 	std::deque<fd_coord_t> panHistoryY_;
+#ifndef _FIXEDPOINT
+	//c of pixel (0,0), always a whole number of pixels away from 0. it is kept in the complex plane instead of in
+	//pixels, so it is as exact as fd_bigfloat_t no matter how deep the dive goes and the rounding of zoom_ only
+	//scales the frame instead of moving it.
+	fd_bigfloat_t originr_ = 0;
+	fd_bigfloat_t origini_ = 0;
+#else
 	fd_coord_t panx_ = 0;
 	fd_coord_t pany_ = 0;
+#endif
+
+	fd_float_t zoomSpeedFactor() const;
 public:
 
 
@@ -38,11 +50,20 @@ public:
 			offsety_(-fd_float_t(config.height_) / 2.0),
 			defaultZoom_(zoomFactor),
 			zoom_(zoomFactor) {
+#ifndef _FIXEDPOINT
+		originr_ = getStepR() * offsetx_;
+		origini_ = getStepI() * offsety_;
+#endif
 	}
 	virtual ~Camera();
 	std::pair<fd_coord_t, fd_coord_t> calculatePanVector(const fd_coord_t& x, const fd_coord_t& y);
 	void zoom(fd_coord_t atX, fd_coord_t atY);
 	void zoomAt(const fd_coord_t& x, const fd_coord_t& y, const fd_float_t& factor, const bool& zoomin);
+	//whether the frame can be zoomed into once more. without fixed point that is as long as fd_bigfloat_t, in which
+	//the reference orbits of perturbation are calculated, resolves the pixels with precisionGuardBits_ to spare (a zoom
+	//of about 1e28 at a width of 768 pixels). fixed point builds stop before the position in pixels overflows
+	//fd_coord_t (a zoom of about 1e17).
+	bool canZoomIn() const;
 	void resetSmoothPan();
 	void initSmoothPan(const fd_coord_t& x, const fd_coord_t& y, const size_t& panSmoothLen);
 	std::pair<fd_coord_t, fd_coord_t> smoothPan(const fd_coord_t& x, const fd_coord_t& y);
@@ -54,15 +75,39 @@ public:
 		srand(time(NULL));
 		offsetx_ = -fd_float_t(config_.width_) / 2.0;
 		offsety_ = -fd_float_t(config_.height_) / 2.0;
+		zoom_ = defaultZoom_;
+#ifndef _FIXEDPOINT
+		originr_ = getStepR() * offsetx_;
+		origini_ = getStepI() * offsety_;
+#else
 		panx_ = 0;
 		pany_ = 0;
-		zoom_ = defaultZoom_;
+#endif
 		zoomCount_ = 0;
 		frameCount_ = 0;
 		panHistoryX_.clear();
 		panHistoryY_.clear();
 	}
 
+	//takes over the position, the zoom and the pan history of another camera, e.g. of a copy of this one taken earlier
+	void restore(const Camera& other) {
+		offsetx_ = other.offsetx_;
+		offsety_ = other.offsety_;
+		defaultZoom_ = other.defaultZoom_;
+		zoom_ = other.zoom_;
+		zoomCount_ = other.zoomCount_;
+		frameCount_ = other.frameCount_;
+		panHistoryX_ = other.panHistoryX_;
+		panHistoryY_ = other.panHistoryY_;
+#ifndef _FIXEDPOINT
+		originr_ = other.originr_;
+		origini_ = other.origini_;
+#else
+		panx_ = other.panx_;
+		pany_ = other.pany_;
+#endif
+	}
+
 	fd_float_t getZoomCount() const {
 		return zoomCount_;
 	}
@@ -75,6 +120,33 @@ public:
 		return zoom_;
 	}
 
+	fd_float_t getOffsetY() const {
+		return offsety_;
+	}
+
+	fd_float_t getOffsetX() const {
+		return offsetx_;
+	}
+
+#ifndef _FIXEDPOINT
+	//c of pixel (0,0)
+	const fd_bigfloat_t& getOriginR() const {
+		return originr_;
+	}
+
+	const fd_bigfloat_t& getOriginI() const {
+		return origini_;
+	}
+
+	//the distance between two columns/rows in the complex plane
+	fd_bigfloat_t getStepR() const {
+		return 10 / (fd_bigfloat_t(zoom_) * config_.width_);
+	}
+
+	fd_bigfloat_t getStepI() const {
+		return 10 / (fd_bigfloat_t(zoom_) * config_.height_);
+	}
+#else
 	fd_float_t getPanY() const {
 		return pany_;
 	}
@@ -83,13 +155,16 @@ public:
 		return panx_;
 	}
 
-	fd_float_t getOffsetY() const {
-		return offsety_;
+	//position of pixel (0,0) in pixels of the current zoom level, as exact as zoomAt() keeps the pan.
+	//getOffsetX() + getPanX() loses precision as soon as the pan doesn't fit into the mantissa of fd_float_t
+	fd_coord_t getOriginX() const {
+		return offsetx_ + panx_;
 	}
 
-	fd_float_t getOffsetX() const {
-		return offsetx_;
+	fd_coord_t getOriginY() const {
+		return offsety_ + pany_;
 	}
+#endif
 };
 } /* namespace fractaldive */
 
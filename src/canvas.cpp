@@ -37,11 +37,11 @@ void Canvas::flip() {
 	}
 }
 
-void Canvas::draw(image_t const& image) {
+void Canvas::draw(const fd_image_pix_t* image) {
 	if (SDL_MUSTLOCK(screen_))
 		SDL_LockSurface(screen_);
 
-	memcpy(static_cast<void*>(screen_->pixels), static_cast<void*>(image), width_ * height_ * sizeof(fd_image_pix_t));
+	memcpy(static_cast<void*>(screen_->pixels), static_cast<const void*>(image), width_ * height_ * sizeof(fd_image_pix_t));
 	flip();
 
 	if (SDL_MUSTLOCK(screen_))
@@ -19,7 +19,7 @@ public:
 	virtual ~Canvas() {
 	}
 	void flip();
-	void draw(image_t const& image);
+	void draw(const fd_image_pix_t* image);
 };
 }
 #endif /* CANVAS_H_ */
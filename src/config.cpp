@@ -1,3 +1,6 @@
+#include <cstdlib>
+#include <cstring>
+
 #include "config.hpp"
 
 namespace fractaldive {
@@ -6,11 +9,29 @@ Config* Config::instance_ = nullptr;
 
 Config::Config() {
 	resetToDefaults();
+	loadEnvironment();
 }
 
 Config::~Config() {
 }
 
+//two native vectors of doubles per call: independent dependency chains without running out of registers
+size_t Config::defaultSimdLanes(const SimdLevel& level) {
+#ifdef _FIXEDPOINT
+	//the fixed point kernels use two AVX2 registers of 4 lanes, also on AVX-512 cpus
+	return 8;
+#else
+	switch (level) {
+	case SIMD_AVX512:
+		return 16;
+	case SIMD_AVX2:
+		return 8;
+	default:
+		return 4;
+	}
+#endif
+}
+
 void Config::resetToDefaults() {
 	fps_ = 24;
 	minIterations_ = 10;
@@ -21,6 +42,7 @@ void Config::resetToDefaults() {
 	zoomFactor_ = 2;
 	panSmoothLen_ = 20;
 	findDetailThreshold_ = 0.1;
+	renderAhead_ = 4;
 #ifndef _AMIGA
 #ifdef _LOW_RES
 	width_ = 128;
@@ -46,6 +68,7 @@ void Config::resetToDefaults() {
 	panSmoothLen_ = 10;
 	maxIterations_ = 300;
 	benchmarkTimeoutMillis_ = 1000;
+	renderAhead_ = 0;
 #endif
 	frameSize_ = width_ * height_;
 
@@ -63,6 +86,216 @@ void Config::resetToDefaults() {
 	#endif
 #endif
 
+	interiorCheck_ = true;
+	formula_ = FORMULA_MANDELBROT;
+	formulaParams_ = FormulaParams();
+	unroll_ = 1;
+	renderMode_ = RENDER_FULL;
+	rectangleTile_ = 64;
+	rectangleMinSize_ = 6;
+	guessingStep_ = 4;
+	schedule_ = SCHEDULE_STEALING;
+	scheduleTile_ = 8;
+	threadStats_ = false;
+	waitPolicy_ = WAIT_PARK;
+	spinMicros_ = 200;
+	pin_ = PIN_NONE;
+	simdLevel_ = detect_simd_level();
+	simdLanes_ = defaultSimdLanes(simdLevel_);
+#ifndef _FIXEDPOINT
+	kernel_ = KERNEL_SIMD;
+#else
+	kernel_ = select_fixed_kernel(simdLevel_, simdLanes_, formula_) != nullptr ? KERNEL_SIMD : KERNEL_SCALAR;
+#endif
+
+#ifndef _FIXEDPOINT
+	//fd_mandelfloat_t runs out of precision between pixels at about that zoom level
+	perturbationZoom_ = 1e12;
+	perturbationReferences_ = 8;
+	reprojection_ = true;
+	distanceEstimation_ = false;
+#else
+	perturbationZoom_ = 0;
+	perturbationReferences_ = 0;
+	reprojection_ = false;
+	distanceEstimation_ = false;
+#endif
+	symmetry_ = true;
+	reprojectionTolerance_ = 0.5;
+	reprojectionRefresh_ = 16;
+#ifndef _FIXEDPOINT
+	autoPrecision_ = true;
+#else
+	autoPrecision_ = false;
+#endif
+	precision_ = PRECISION_DOUBLE;
+	precisionGuardBits_ = 12;
+
+}
+
+//overrides for benchmarking. e.g.: FD_KERNEL=scalar ./dive
+void Config::loadEnvironment() {
+	const char* kernel = std::getenv("FD_KERNEL");
+	if (kernel != nullptr) {
+		if (std::strcmp(kernel, "scalar") == 0)
+			kernel_ = KERNEL_SCALAR;
+		else if (std::strcmp(kernel, "simd") == 0)
+			kernel_ = KERNEL_SIMD;
+		else if (std::strcmp(kernel, "persistent") == 0)
+			kernel_ = KERNEL_SIMD_PERSISTENT;
+	}
+
+	const char* mode = std::getenv("FD_RENDER_MODE");
+	if (mode != nullptr) {
+		if (std::strcmp(mode, "full") == 0)
+			renderMode_ = RENDER_FULL;
+		else if (std::strcmp(mode, "rectangles") == 0)
+			renderMode_ = RENDER_RECTANGLES;
+		else if (std::strcmp(mode, "guessing") == 0)
+			renderMode_ = RENDER_GUESSING;
+	}
+
+	const char* guessingStep = std::getenv("FD_GUESSING_STEP");
+	if (guessingStep != nullptr) {
+		fd_dim_t s = std::strtoul(guessingStep, nullptr, 10);
+		if (s >= 2)
+			guessingStep_ = s;
+	}
+
+	const char* schedule = std::getenv("FD_SCHEDULE");
+	if (schedule != nullptr) {
+		if (std::strcmp(schedule, "stripes") == 0)
+			schedule_ = SCHEDULE_STRIPES;
+		else if (std::strcmp(schedule, "stealing") == 0)
+			schedule_ = SCHEDULE_STEALING;
+		else if (std::strcmp(schedule, "cost") == 0)
+			schedule_ = SCHEDULE_COST;
+	}
+
+	const char* scheduleTile = std::getenv("FD_SCHEDULE_TILE");
+	if (scheduleTile != nullptr) {
+		fd_dim_t t = std::strtoul(scheduleTile, nullptr, 10);
+		if (t >= 1)
+			scheduleTile_ = t;
+	}
+
+	const char* threadStats = std::getenv("FD_THREAD_STATS");
+	if (threadStats != nullptr)
+		threadStats_ = std::strcmp(threadStats, "0") != 0;
+
+	const char* wait = std::getenv("FD_WAIT");
+	if (wait != nullptr) {
+		if (std::strcmp(wait, "park") == 0)
+			waitPolicy_ = WAIT_PARK;
+		else if (std::strcmp(wait, "spin") == 0)
+			waitPolicy_ = WAIT_SPIN;
+	}
+
+	const char* spin = std::getenv("FD_SPIN_MICROS");
+	if (spin != nullptr)
+		spinMicros_ = std::strtoul(spin, nullptr, 10);
+
+	const char* renderAhead = std::getenv("FD_RENDER_AHEAD");
+	if (renderAhead != nullptr)
+		renderAhead_ = std::strtoul(renderAhead, nullptr, 10);
+
+	const char* pin = std::getenv("FD_PIN");
+	if (pin != nullptr)
+		parse_pin_policy(pin, pin_);
+
+	const char* interior = std::getenv("FD_INTERIOR_CHECK");
+	if (interior != nullptr)
+		interiorCheck_ = std::strcmp(interior, "0") != 0;
+
+	const char* formula = std::getenv("FD_FORMULA");
+	if (formula != nullptr)
+		parse_formula(formula, formula_);
+
+	//the julia constant as "re,im"
+	const char* julia = std::getenv("FD_JULIA");
+	if (julia != nullptr) {
+		char* end = nullptr;
+		const fd_float_t r = std::strtod(julia, &end);
+		if (end != julia && *end == ',') {
+			const char* imag = end + 1;
+			const fd_float_t i = std::strtod(imag, &end);
+			if (end != imag) {
+				formulaParams_.juliar_ = r;
+				formulaParams_.juliai_ = i;
+			}
+		}
+	}
+
+	const char* symmetry = std::getenv("FD_SYMMETRY");
+	if (symmetry != nullptr)
+		symmetry_ = std::strcmp(symmetry, "0") != 0;
+
+	const char* unroll = std::getenv("FD_UNROLL");
+	if (unroll != nullptr) {
+		size_t u = std::strtoul(unroll, nullptr, 10);
+		if (u == 1 || u == 2 || u == 4 || u == 8)
+			unroll_ = u;
+	}
+
+	//only levels the cpu supports are accepted. they are ordered so every level implies the ones below.
+	const char* simd = std::getenv("FD_SIMD");
+	SimdLevel level;
+	if (simd != nullptr && parse_simd_level(simd, level) && level <= detect_simd_level()) {
+		simdLevel_ = level;
+		simdLanes_ = defaultSimdLanes(simdLevel_);
+	}
+
+	const char* lanes = std::getenv("FD_SIMD_LANES");
+	if (lanes != nullptr) {
+		size_t l = std::strtoul(lanes, nullptr, 10);
+		if (l == 4 || l == 8 || l == 16)
+			simdLanes_ = l;
+	}
+
+#ifdef _FIXEDPOINT
+	//there is no fallback for the fixed point simd kernel on other instruction sets and formulas
+	if (kernel_ != KERNEL_SCALAR && select_fixed_kernel(simdLevel_, simdLanes_, formula_) == nullptr)
+		kernel_ = KERNEL_SCALAR;
+#endif
+
+#ifndef _FIXEDPOINT
+	const char* perturbationZoom = std::getenv("FD_PERTURBATION_ZOOM");
+	if (perturbationZoom != nullptr)
+		perturbationZoom_ = std::strtod(perturbationZoom, nullptr);
+
+	const char* perturbationReferences = std::getenv("FD_PERTURBATION_REFERENCES");
+	if (perturbationReferences != nullptr) {
+		size_t r = std::strtoul(perturbationReferences, nullptr, 10);
+		if (r > 0)
+			perturbationReferences_ = r;
+	}
 
+	const char* precision = std::getenv("FD_PRECISION");
+	if (precision != nullptr) {
+		if (std::strcmp(precision, "auto") == 0)
+			autoPrecision_ = true;
+		else if (parse_precision(precision, precision_))
+			autoPrecision_ = false;
+	}
+
+	const char* reprojection = std::getenv("FD_REPROJECTION");
+	if (reprojection != nullptr)
+		reprojection_ = std::strcmp(reprojection, "0") != 0;
+
+	const char* distance = std::getenv("FD_DISTANCE_ESTIMATION");
+	if (distance != nullptr)
+		distanceEstimation_ = std::strcmp(distance, "0") != 0;
+
+	const char* tolerance = std::getenv("FD_REPROJECTION_TOLERANCE");
+	if (tolerance != nullptr) {
+		fd_float_t t = std::strtod(tolerance, nullptr);
+		if (t >= 0 && t <= 0.5)
+			reprojectionTolerance_ = t;
+	}
+
+	const char* refresh = std::getenv("FD_REPROJECTION_REFRESH");
+	if (refresh != nullptr)
+		reprojectionRefresh_ = std::strtoul(refresh, nullptr, 10);
+#endif
 }
 } /* namespace fractaldive */
@@ -2,9 +2,38 @@
 #define SRC_CONFIG_HPP_
 
 #include "types.hpp"
+#include "dispatch.hpp"
+#include "precision.hpp"
+#include "formula.hpp"
+#include "threadpool.hpp"
+#include "topology.hpp"
 
 namespace fractaldive {
 
+enum KernelMode {
+	KERNEL_SCALAR,
+	KERNEL_SIMD,
+	KERNEL_SIMD_PERSISTENT
+};
+
+enum RenderMode {
+	//calculate every pixel
+	RENDER_FULL,
+	//Mariani-Silver: fill tiles with a uniform border, subdivide the others
+	RENDER_RECTANGLES,
+	//Fractint style solid guessing: calculate a coarse grid and refine only cells whose corners differ
+	RENDER_GUESSING
+};
+
+enum Schedule {
+	//one horizontal stripe per thread
+	SCHEDULE_STRIPES,
+	//tiles of a few rows in a deque per thread, threads that run dry steal from the others
+	SCHEDULE_STEALING,
+	//one contiguous run of tiles per thread, of the same cost according to the previous frame
+	SCHEDULE_COST
+};
+
 class Config {
 private:
 	static Config* instance_;
@@ -24,7 +53,52 @@ public:
 	fd_float_t zoomFactor_ = 0;
 	fd_float_t zoomSpeed_ = 0;
 	fd_float_t fps_ = 0;
+	//frames the autopilot renders ahead of displaying them, 0 renders every frame right before it is due
+	size_t renderAhead_ = 0;
 	fd_float_t findDetailThreshold_ = 0;
+	KernelMode kernel_ = KERNEL_SCALAR;
+	size_t simdLanes_ = 0;
+	//instruction set the simd kernels run with. defaults to the best one the cpu supports.
+	SimdLevel simdLevel_ = SIMD_GENERIC;
+	bool interiorCheck_ = true;
+	Formula formula_ = FORMULA_MANDELBROT;
+	FormulaParams formulaParams_;
+	//the scalar kernel checks for escaped orbits every unroll_ iterations (1, 2, 4 or 8) and replays the last block on escape
+	size_t unroll_ = 1;
+	RenderMode renderMode_ = RENDER_FULL;
+	//size of the tiles RENDER_RECTANGLES starts with and under which it stops subdividing
+	fd_dim_t rectangleTile_ = 0;
+	fd_dim_t rectangleMinSize_ = 0;
+	//distance between the pixels of the coarse grid RENDER_GUESSING starts with
+	fd_dim_t guessingStep_ = 0;
+	//how the frame is distributed among the threads and the number of rows of the tiles of SCHEDULE_STEALING/SCHEDULE_COST
+	Schedule schedule_ = SCHEDULE_STEALING;
+	fd_dim_t scheduleTile_ = 0;
+	//print the busy and idle time of every thread for every frame
+	bool threadStats_ = false;
+	//what idle threads do and how long they spin with WAIT_SPIN
+	WaitPolicy waitPolicy_ = WAIT_PARK;
+	size_t spinMicros_ = 0;
+	//which cpus the threads are pinned to
+	PinPolicy pin_ = PIN_NONE;
+	//zoom level from which on frames are rendered by perturbation. 0 disables perturbation.
+	fd_float_t perturbationZoom_ = 0;
+	size_t perturbationReferences_ = 0;
+	//reuse pixels of the previous frame that are less than reprojectionTolerance_ pixels off and recalculate every
+	//pixel at least every reprojectionRefresh_ frames
+	bool reprojection_ = false;
+	//track the derivative of the orbits and keep the distance of every pixel to the boundary of the set, which the
+	//autopilot steers by
+	bool distanceEstimation_ = false;
+	//calculate only one side of the real axis if the frame contains it and mirror the other
+	bool symmetry_ = false;
+	fd_float_t reprojectionTolerance_ = 0;
+	size_t reprojectionRefresh_ = 0;
+	//iterate every frame with the cheapest floating point type that has precisionGuardBits_ more bits than the pixel
+	//spacing needs, otherwise always with precision_
+	bool autoPrecision_ = false;
+	Precision precision_ = PRECISION_DOUBLE;
+	size_t precisionGuardBits_ = 0;
 	static Config& getInstance() {
 		if (instance_ == nullptr)
 			instance_ = new Config();
@@ -32,7 +106,9 @@ public:
 		return *instance_;
 	}
 
+	static size_t defaultSimdLanes(const SimdLevel& level);
 	void resetToDefaults();
+	void loadEnvironment();
 };
 
 } /* namespace fractaldive */
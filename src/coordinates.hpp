@@ -0,0 +1,88 @@
+#ifndef SRC_COORDINATES_HPP_
+#define SRC_COORDINATES_HPP_
+
+#include <vector>
+
+#include "types.hpp"
+#include "camera.hpp"
+
+namespace fractaldive {
+
+//c of every column (pointr_) and row (pointi_) of a frame. generated once per frame so the kernels only read them,
+//instead of converting every pixel position with a division by the zoom (in fd_bigfloat_t, which is soft-float on x86).
+class Coordinates {
+public:
+	std::vector<fd_mandelfloat_t> pointr_;
+	std::vector<fd_mandelfloat_t> pointi_;
+#ifndef _FIXEDPOINT
+	//the same in full precision for the precisions beyond double
+	std::vector<fd_bigfloat_t> bigPointr_;
+	std::vector<fd_bigfloat_t> bigPointi_;
+#endif
+
+	Coordinates(const fd_dim_t& width, const fd_dim_t& height) :
+			pointr_(width),
+			pointi_(height)
+#ifndef _FIXEDPOINT
+			, bigPointr_(width),
+			bigPointi_(height)
+#endif
+	{
+	}
+
+	void generate(const Camera& camera) {
+#ifndef _FIXEDPOINT
+		//pixel (0,0) from the exact camera position, then one addition per column/row. the error that accumulates
+		//over a row is far below the resolution of double-double.
+		generateAxis(camera.getOriginR(), camera.getStepR(), bigPointr_, pointr_);
+		generateAxis(camera.getOriginI(), camera.getStepI(), bigPointi_, pointi_);
+#elif defined(_FIXEDPOINT_LIMBS)
+		//the step exact to the last bit of the multi-limb type. every column/row is its position times the step, the
+		//error of the step multiplied by the position stays far below the resolution.
+		const fd_mandelfloat_t extent = fd_mandelfloat_t::Reciprocal(camera.getZoom()) * 10;
+		generateAxis(camera.getOriginX(), extent / pointr_.size(), pointr_);
+		generateAxis(camera.getOriginY(), extent / pointi_.size(), pointi_);
+#else
+		//a fixed point step is off by up to half an ulp, which would add up over a row. every column/row is calculated
+		//from its position instead, as Renderer::mandelbrot used to do per pixel.
+		const fd_float_t scale = camera.getZoom() / 10.0;
+		for (size_t x = 0; x < pointr_.size(); ++x) {
+			fd_mandelfloat_t x0 = (x + camera.getOffsetX() + camera.getPanX()) / scale;
+			pointr_[x] = x0 / pointr_.size();
+		}
+		for (size_t y = 0; y < pointi_.size(); ++y) {
+			fd_mandelfloat_t y0 = (y + camera.getOffsetY() + camera.getPanY()) / scale;
+			pointi_[y] = y0 / pointi_.size();
+		}
+#endif
+	}
+
+	void swap(Coordinates& other) {
+		pointr_.swap(other.pointr_);
+		pointi_.swap(other.pointi_);
+#ifndef _FIXEDPOINT
+		bigPointr_.swap(other.bigPointr_);
+		bigPointi_.swap(other.bigPointi_);
+#endif
+	}
+private:
+#ifndef _FIXEDPOINT
+	static void generateAxis(const fd_bigfloat_t& origin, const fd_bigfloat_t& step, std::vector<fd_bigfloat_t>& big, std::vector<fd_mandelfloat_t>& points) {
+		fd_bigfloat_t c = origin;
+		for (size_t i = 0; i < points.size(); ++i) {
+			big[i] = c;
+			points[i] = fd_mandelfloat_t(c);
+			c += step;
+		}
+	}
+#elif defined(_FIXEDPOINT_LIMBS)
+	static void generateAxis(const fd_coord_t& origin, const fd_mandelfloat_t& step, std::vector<fd_mandelfloat_t>& points) {
+		for (size_t i = 0; i < points.size(); ++i)
+			points[i] = step * fd_coord_t(origin + i);
+	}
+#endif
+};
+
+} /* namespace fractaldive */
+
+#endif /* SRC_COORDINATES_HPP_ */
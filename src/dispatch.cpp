@@ -0,0 +1,176 @@
+#include "dispatch.hpp"
+
+#include <cstring>
+
+namespace fractaldive {
+
+#if defined(__x86_64__) || defined(__i386__)
+#define FD_SIMD_DISPATCH
+#endif
+
+//keep the compiler from contracting a*b+c into fma (avx512f implies fma, -Ofast allows it),
+//so that every instruction set renders the same frame.
+#ifdef __clang__
+#pragma STDC FP_CONTRACT OFF
+#define FD_NO_FP_CONTRACT
+#define FD_DISPATCH_TARGET(isa) __attribute__((target(isa)))
+#else
+#define FD_NO_FP_CONTRACT __attribute__((optimize("fp-contract=off")))
+#define FD_DISPATCH_TARGET(isa) __attribute__((target(isa), optimize("fp-contract=off")))
+#endif
+
+SimdLevel detect_simd_level() {
+#ifdef FD_SIMD_DISPATCH
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f"))
+		return SIMD_AVX512;
+	if (__builtin_cpu_supports("avx2"))
+		return SIMD_AVX2;
+	if (__builtin_cpu_supports("sse2"))
+		return SIMD_SSE2;
+#endif
+	return SIMD_GENERIC;
+}
+
+const char* simd_level_name(const SimdLevel& level) {
+	switch (level) {
+	case SIMD_SSE2:
+		return "sse2";
+	case SIMD_AVX2:
+		return "avx2";
+	case SIMD_AVX512:
+		return "avx512";
+	default:
+		return "generic";
+	}
+}
+
+bool parse_simd_level(const char* name, SimdLevel& level) {
+	const SimdLevel levels[] = { SIMD_GENERIC, SIMD_SSE2, SIMD_AVX2, SIMD_AVX512 };
+	for (const SimdLevel& l : levels) {
+		if (std::strcmp(name, simd_level_name(l)) == 0) {
+			level = l;
+			return true;
+		}
+	}
+	return false;
+}
+
+template<typename Kernel>
+Kernel select_lanes(const size_t& lanes, Kernel k4, Kernel k8, Kernel k16) {
+	switch (lanes) {
+	case 16:
+		return k16;
+	case 8:
+		return k8;
+	default:
+		return k4;
+	}
+}
+
+#ifndef _FIXEDPOINT
+template<typename T, size_t Lanes, typename F>
+FD_NO_FP_CONTRACT void simd_generic(const fd_mandelfloat_t* pointr, const fd_mandelfloat_t* pointi, fd_iter_count_t* iterations, const size_t& size, const fd_iter_count_t& currentIt, const bool& checkInterior, const FormulaParams& params, LaneStats& stats) {
+	mandelbrot_simd<T, Lanes, FD_SIMD_BYTES, fd_mandelfloat_t, F>(pointr, pointi, iterations, size, currentIt, checkInterior, params, stats);
+}
+
+template<typename T, size_t Lanes, typename F>
+FD_NO_FP_CONTRACT void persistent_generic(const fd_mandelfloat_t* pointr, const fd_mandelfloat_t* pointi, const size_t& width, const size_t& rows, fd_iter_count_t* iterations, const fd_iter_count_t& currentIt, const bool& checkInterior, const FormulaParams& params, LaneStats& stats) {
+	mandelbrot_persistent<T, Lanes, FD_SIMD_BYTES, fd_mandelfloat_t, F>(pointr, pointi, width, rows, iterations, currentIt, checkInterior, params, stats);
+}
+
+#ifdef FD_SIMD_DISPATCH
+//the kernels are inlined into these functions, so they are compiled for the instruction set of the target attribute
+//no matter what the rest of the build targets.
+template<typename T, size_t Lanes, typename F>
+FD_DISPATCH_TARGET("sse2") void simd_sse2(const fd_mandelfloat_t* pointr, const fd_mandelfloat_t* pointi, fd_iter_count_t* iterations, const size_t& size, const fd_iter_count_t& currentIt, const bool& checkInterior, const FormulaParams& params, LaneStats& stats) {
+	mandelbrot_simd<T, Lanes, 16, fd_mandelfloat_t, F>(pointr, pointi, iterations, size, currentIt, checkInterior, params, stats);
+}
+
+template<typename T, size_t Lanes, typename F>
+FD_DISPATCH_TARGET("sse2") void persistent_sse2(const fd_mandelfloat_t* pointr, const fd_mandelfloat_t* pointi, const size_t& width, const size_t& rows, fd_iter_count_t* iterations, const fd_iter_count_t& currentIt, const bool& checkInterior, const FormulaParams& params, LaneStats& stats) {
+	mandelbrot_persistent<T, Lanes, 16, fd_mandelfloat_t, F>(pointr, pointi, width, rows, iterations, currentIt, checkInterior, params, stats);
+}
+
+template<typename T, size_t Lanes, typename F>
+FD_DISPATCH_TARGET("avx2") void simd_avx2(const fd_mandelfloat_t* pointr, const fd_mandelfloat_t* pointi, fd_iter_count_t* iterations, const size_t& size, const fd_iter_count_t& currentIt, const bool& checkInterior, const FormulaParams& params, LaneStats& stats) {
+	mandelbrot_simd<T, Lanes, 32, fd_mandelfloat_t, F>(pointr, pointi, iterations, size, currentIt, checkInterior, params, stats);
+}
+
+template<typename T, size_t Lanes, typename F>
+FD_DISPATCH_TARGET("avx2") void persistent_avx2(const fd_mandelfloat_t* pointr, const fd_mandelfloat_t* pointi, const size_t& width, const size_t& rows, fd_iter_count_t* iterations, const fd_iter_count_t& currentIt, const bool& checkInterior, const FormulaParams& params, LaneStats& stats) {
+	mandelbrot_persistent<T, Lanes, 32, fd_mandelfloat_t, F>(pointr, pointi, width, rows, iterations, currentIt, checkInterior, params, stats);
+}
+
+template<typename T, size_t Lanes, typename F>
+FD_DISPATCH_TARGET("avx512f") void simd_avx512(const fd_mandelfloat_t* pointr, const fd_mandelfloat_t* pointi, fd_iter_count_t* iterations, const size_t& size, const fd_iter_count_t& currentIt, const bool& checkInterior, const FormulaParams& params, LaneStats& stats) {
+	mandelbrot_simd<T, Lanes, 64, fd_mandelfloat_t, F>(pointr, pointi, iterations, size, currentIt, checkInterior, params, stats);
+}
+
+template<typename T, size_t Lanes, typename F>
+FD_DISPATCH_TARGET("avx512f") void persistent_avx512(const fd_mandelfloat_t* pointr, const fd_mandelfloat_t* pointi, const size_t& width, const size_t& rows, fd_iter_count_t* iterations, const fd_iter_count_t& currentIt, const bool& checkInterior, const FormulaParams& params, LaneStats& stats) {
+	mandelbrot_persistent<T, Lanes, 64, fd_mandelfloat_t, F>(pointr, pointi, width, rows, iterations, currentIt, checkInterior, params, stats);
+}
+#endif
+
+#define FD_SELECT_LANES(KERNEL, LANES, PRECISION, F) ((PRECISION) == PRECISION_FLOAT ? \
+		select_lanes(LANES, KERNEL<float, 8, F>, KERNEL<float, 16, F>, KERNEL<float, 32, F>) : \
+		select_lanes(LANES, KERNEL<double, 4, F>, KERNEL<double, 8, F>, KERNEL<double, 16, F>))
+
+#define FD_SELECT_KERNEL(KERNEL, LANES, PRECISION, FORMULA) ( \
+		(FORMULA) == FORMULA_JULIA ? FD_SELECT_LANES(KERNEL, LANES, PRECISION, Julia) : \
+		(FORMULA) == FORMULA_BURNING_SHIP ? FD_SELECT_LANES(KERNEL, LANES, PRECISION, BurningShip) : \
+		(FORMULA) == FORMULA_MULTIBROT3 ? FD_SELECT_LANES(KERNEL, LANES, PRECISION, Multibrot<3>) : \
+		(FORMULA) == FORMULA_MULTIBROT4 ? FD_SELECT_LANES(KERNEL, LANES, PRECISION, Multibrot<4>) : \
+		FD_SELECT_LANES(KERNEL, LANES, PRECISION, Mandelbrot))
+
+simd_kernel_t select_simd_kernel(const SimdLevel& level, const size_t& lanes, const Precision& precision, const Formula& formula) {
+	switch (level) {
+#ifdef FD_SIMD_DISPATCH
+	case SIMD_SSE2:
+		return FD_SELECT_KERNEL(simd_sse2, lanes, precision, formula);
+	case SIMD_AVX2:
+		return FD_SELECT_KERNEL(simd_avx2, lanes, precision, formula);
+	case SIMD_AVX512:
+		return FD_SELECT_KERNEL(simd_avx512, lanes, precision, formula);
+#endif
+	default:
+		return FD_SELECT_KERNEL(simd_generic, lanes, precision, formula);
+	}
+}
+
+persistent_kernel_t select_persistent_kernel(const SimdLevel& level, const size_t& lanes, const Precision& precision, const Formula& formula) {
+	switch (level) {
+#ifdef FD_SIMD_DISPATCH
+	case SIMD_SSE2:
+		return FD_SELECT_KERNEL(persistent_sse2, lanes, precision, formula);
+	case SIMD_AVX2:
+		return FD_SELECT_KERNEL(persistent_avx2, lanes, precision, formula);
+	case SIMD_AVX512:
+		return FD_SELECT_KERNEL(persistent_avx512, lanes, precision, formula);
+#endif
+	default:
+		return FD_SELECT_KERNEL(persistent_generic, lanes, precision, formula);
+	}
+}
+#undef FD_SELECT_KERNEL
+#undef FD_SELECT_LANES
+#else
+simd_kernel_t select_fixed_kernel(const SimdLevel& level, const size_t& lanes, const Formula& formula) {
+#ifdef FD_FIXED_SIMD
+	if (level >= SIMD_AVX2 && formula == FORMULA_MANDELBROT)
+		return select_lanes<simd_kernel_t>(lanes, mandelbrot_fixed_simd<fd_mandelfloat_t, 4>, mandelbrot_fixed_simd<fd_mandelfloat_t, 8>, mandelbrot_fixed_simd<fd_mandelfloat_t, 16>);
+#endif
+	return nullptr;
+}
+
+persistent_kernel_t select_fixed_persistent_kernel(const SimdLevel& level, const size_t& lanes, const Formula& formula) {
+#ifdef FD_FIXED_SIMD
+	if (level >= SIMD_AVX2 && formula == FORMULA_MANDELBROT)
+		return select_lanes<persistent_kernel_t>(lanes, mandelbrot_fixed_persistent<fd_mandelfloat_t, 4>, mandelbrot_fixed_persistent<fd_mandelfloat_t, 8>, mandelbrot_fixed_persistent<fd_mandelfloat_t, 16>);
+#endif
+	return nullptr;
+}
+#endif
+
+} /* namespace fractaldive */
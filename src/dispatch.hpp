@@ -0,0 +1,47 @@
+#ifndef SRC_DISPATCH_HPP_
+#define SRC_DISPATCH_HPP_
+
+#include <cstddef>
+
+#include "types.hpp"
+#include "kernel.hpp"
+#include "precision.hpp"
+#include "formula.hpp"
+
+namespace fractaldive {
+
+//instruction set levels the simd kernels are built for. SIMD_GENERIC is whatever the build flags target (e.g. NEON or
+//simd128), the others are x86 only and picked at runtime.
+enum SimdLevel {
+	SIMD_GENERIC,
+	SIMD_SSE2,
+	SIMD_AVX2,
+	SIMD_AVX512
+};
+
+//the best level the cpu supports
+SimdLevel detect_simd_level();
+const char* simd_level_name(const SimdLevel& level);
+//parses a level name as returned by simd_level_name(). returns false for unknown names.
+bool parse_simd_level(const char* name, SimdLevel& level);
+
+typedef void (*simd_kernel_t)(const fd_mandelfloat_t* pointr, const fd_mandelfloat_t* pointi, fd_iter_count_t* iterations, const size_t& size, const fd_iter_count_t& currentIt, const bool& checkInterior, const FormulaParams& params, LaneStats& stats);
+typedef void (*persistent_kernel_t)(const fd_mandelfloat_t* pointr, const fd_mandelfloat_t* pointi, const size_t& width, const size_t& rows, fd_iter_count_t* iterations, const fd_iter_count_t& currentIt, const bool& checkInterior, const FormulaParams& params, LaneStats& stats);
+
+#ifdef _FIXEDPOINT
+//the integer simd kernels of the fixed point build for the given number of lanes (4, 8 or 16). they only exist for
+//x86 with AVX2 (and the 32-bit fixed point types) and for FORMULA_MANDELBROT, otherwise they are nullptr.
+simd_kernel_t select_fixed_kernel(const SimdLevel& level, const size_t& lanes, const Formula& formula);
+persistent_kernel_t select_fixed_persistent_kernel(const SimdLevel& level, const size_t& lanes, const Formula& formula);
+#else
+
+//the instantiations of mandelbrot_simd/mandelbrot_persistent for the given level, number of lanes (4, 8 or 16) and
+//formula. PRECISION_FLOAT iterates twice the number of lanes, since twice as many floats fit into a register. the kernels only
+//exist for float and double.
+simd_kernel_t select_simd_kernel(const SimdLevel& level, const size_t& lanes, const Precision& precision, const Formula& formula);
+persistent_kernel_t select_persistent_kernel(const SimdLevel& level, const size_t& lanes, const Precision& precision, const Formula& formula);
+#endif
+
+} /* namespace fractaldive */
+
+#endif /* SRC_DISPATCH_HPP_ */
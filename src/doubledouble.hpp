@@ -0,0 +1,111 @@
+#ifndef SRC_DOUBLEDOUBLE_HPP_
+#define SRC_DOUBLEDOUBLE_HPP_
+
+#include <cmath>
+
+#include "types.hpp"
+#include "kernel.hpp"
+
+namespace fractaldive {
+
+#ifndef _FIXEDPOINT
+//an unevaluated sum of two doubles (hi_ + lo_, |lo_| <= ulp(hi_) / 2) with about 106 bits of mantissa. a lot faster
+//than the soft-float __float128 while almost as precise.
+//the error-free transformations below rely on the exact order of the floating point operations. code using this type
+//must not be compiled with -ffast-math (or -fassociative-math), see precision.cpp.
+class DoubleDouble {
+	//s + e == a + b exactly
+	static void twoSum(const double& a, const double& b, double& s, double& e) {
+		s = a + b;
+		const double bb = s - a;
+		e = (a - (s - bb)) + (b - bb);
+	}
+
+	//same as twoSum() for |a| >= |b|
+	static void quickTwoSum(const double& a, const double& b, double& s, double& e) {
+		s = a + b;
+		e = b - (s - a);
+	}
+
+	//p + e == a * b exactly (Dekker). doesn't need fma, which the baseline x86 targets don't have.
+	static void twoProd(const double& a, const double& b, double& p, double& e) {
+		const double split = 134217729.0; //2^27 + 1
+		p = a * b;
+		const double ta = split * a;
+		const double ahi = ta - (ta - a);
+		const double alo = a - ahi;
+		const double tb = split * b;
+		const double bhi = tb - (tb - b);
+		const double blo = b - bhi;
+		e = ((ahi * bhi - p) + ahi * blo + alo * bhi) + alo * blo;
+	}
+public:
+	double hi_;
+	double lo_;
+
+	DoubleDouble() :
+			hi_(0), lo_(0) {
+	}
+
+	DoubleDouble(const double& v) :
+			hi_(v), lo_(0) {
+	}
+
+	DoubleDouble(const double& hi, const double& lo) :
+			hi_(hi), lo_(lo) {
+	}
+
+	explicit DoubleDouble(const fd_bigfloat_t& v) :
+			hi_(double(v)), lo_(double(v - fd_bigfloat_t(hi_))) {
+	}
+
+	DoubleDouble operator-() const {
+		return DoubleDouble(-hi_, -lo_);
+	}
+
+	DoubleDouble operator+(const DoubleDouble& other) const {
+		double s, e;
+		twoSum(hi_, other.hi_, s, e);
+		e += lo_ + other.lo_;
+		DoubleDouble result;
+		quickTwoSum(s, e, result.hi_, result.lo_);
+		return result;
+	}
+
+	DoubleDouble operator-(const DoubleDouble& other) const {
+		return *this + -other;
+	}
+
+	DoubleDouble operator*(const DoubleDouble& other) const {
+		double p, e;
+		twoProd(hi_, other.hi_, p, e);
+		e += hi_ * other.lo_ + lo_ * other.hi_;
+		DoubleDouble result;
+		quickTwoSum(p, e, result.hi_, result.lo_);
+		return result;
+	}
+
+	DoubleDouble& operator+=(const DoubleDouble& other) {
+		return *this = *this + other;
+	}
+
+	bool operator<(const DoubleDouble& other) const {
+		return hi_ < other.hi_ || (hi_ == other.hi_ && lo_ < other.lo_);
+	}
+
+	bool operator<=(const DoubleDouble& other) const {
+		return hi_ < other.hi_ || (hi_ == other.hi_ && lo_ <= other.lo_);
+	}
+};
+
+template<>
+struct Periodicity<DoubleDouble> {
+	static DoubleDouble epsilon() {
+		return DoubleDouble(std::ldexp(1.0, -104) * 64.0);
+	}
+};
+#endif
+
+} /* namespace fractaldive */
+
+#endif /* SRC_DOUBLEDOUBLE_HPP_ */
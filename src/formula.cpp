@@ -0,0 +1,48 @@
+#include "formula.hpp"
+
+#include <cstring>
+
+namespace fractaldive {
+
+const char* formula_name(const Formula& formula) {
+	switch (formula) {
+	case FORMULA_JULIA:
+		return "julia";
+	case FORMULA_BURNING_SHIP:
+		return "burning-ship";
+	case FORMULA_MULTIBROT3:
+		return "multibrot3";
+	case FORMULA_MULTIBROT4:
+		return "multibrot4";
+	default:
+		return "mandelbrot";
+	}
+}
+
+bool parse_formula(const char* name, Formula& formula) {
+	const Formula formulas[] = { FORMULA_MANDELBROT, FORMULA_JULIA, FORMULA_BURNING_SHIP, FORMULA_MULTIBROT3, FORMULA_MULTIBROT4 };
+	for (const Formula& f : formulas) {
+		if (std::strcmp(name, formula_name(f)) == 0) {
+			formula = f;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool is_conjugate_symmetric(const Formula& formula, const FormulaParams& params) {
+	switch (formula) {
+	case FORMULA_BURNING_SHIP:
+		return false;
+	case FORMULA_JULIA:
+		return params.juliai_ == 0;
+	default:
+		return true;
+	}
+}
+
+bool has_distance_estimate(const Formula& formula) {
+	return formula == FORMULA_MANDELBROT || formula == FORMULA_JULIA;
+}
+
+} /* namespace fractaldive */
@@ -0,0 +1,39 @@
+#ifndef SRC_FORMULA_HPP_
+#define SRC_FORMULA_HPP_
+
+#include "types.hpp"
+
+namespace fractaldive {
+
+//the escape time formulas. every one of them iterates z -> f(z) + c and bails out at |z| > 2. the kernels are
+//instantiated with a policy type per formula (see kernel.hpp).
+enum Formula {
+	//z^2 + c, z starting at 0 and c at the pixel
+	FORMULA_MANDELBROT,
+	//z^2 + c, z starting at the pixel and c the constant of FormulaParams
+	FORMULA_JULIA,
+	//(|re z| + i|im z|)^2 + c
+	FORMULA_BURNING_SHIP,
+	//z^3 + c and z^4 + c
+	FORMULA_MULTIBROT3,
+	FORMULA_MULTIBROT4
+};
+
+const char* formula_name(const Formula& formula);
+//parses a name as returned by formula_name(). returns false for unknown names.
+bool parse_formula(const char* name, Formula& formula);
+
+//the runtime parameters of the formulas
+struct FormulaParams {
+	fd_float_t juliar_ = -0.8;
+	fd_float_t juliai_ = 0.156;
+};
+
+//whether the conjugate of a point has the same iteration count, i.e. the formula has only real coefficients
+bool is_conjugate_symmetric(const Formula& formula, const FormulaParams& params);
+//whether the distance estimation kernel (see mandelbrot_point_distance()) knows the derivative of the formula
+bool has_distance_estimate(const Formula& formula);
+
+} /* namespace fractaldive */
+
+#endif /* SRC_FORMULA_HPP_ */
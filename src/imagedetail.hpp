@@ -87,11 +87,12 @@ fd_float_t numberOfColors(const image_t& image, const size_t& size) {
 //	return (fd_float_t(numChanges) / fd_float_t(width * height));
 //}
 
-inline fd_float_t numberOfChanges(const image_t& image, const size_t& size) {
+template<typename T>
+inline fd_float_t numberOfChanges(const T* image, const size_t& size) {
 	fd_float_t numChanges = 0;
-	fd_image_pix_t last = 0;
+	T last = 0;
 	for (size_t i = 0; i < size; i++) {
-		const fd_image_pix_t& p = image[i];
+		const T& p = image[i];
 		if (last != p) {
 			++numChanges;
 		}
@@ -101,7 +102,9 @@ inline fd_float_t numberOfChanges(const image_t& image, const size_t& size) {
 	return (fd_float_t(numChanges) / fd_float_t(size));
 }
 
-inline fd_float_t measureImageDetail(const image_t& image, const size_t& size) {
+//works on colors as well as on iteration counts
+template<typename T>
+inline fd_float_t measureImageDetail(const T* image, const size_t& size) {
 	return numberOfChanges(image, size);
 }
 }
@@ -0,0 +1,85 @@
+#ifndef SRC_ITERATIONBUFFER_HPP_
+#define SRC_ITERATIONBUFFER_HPP_
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+#include "types.hpp"
+
+namespace fractaldive {
+
+//the iteration counts of a frame. stored as uint16_t as long as the maximum iteration count fits, as
+//fd_iter_count_t otherwise.
+class IterationBuffer {
+	size_t size_;
+	bool compact_;
+	std::vector<uint16_t> compactData_;
+	std::vector<fd_iter_count_t> wideData_;
+public:
+	IterationBuffer(const size_t& size) :
+			size_(size), compact_(true), compactData_(size, 0) {
+	}
+
+	//selects the storage for frames with up to maxIterations iterations. the content is undefined after switching.
+	void reserve(const fd_iter_count_t& maxIterations) {
+		bool compact = maxIterations <= std::numeric_limits<uint16_t>::max();
+		if (compact == compact_)
+			return;
+
+		compact_ = compact;
+		if (compact_) {
+			compactData_.resize(size_, 0);
+			wideData_ = std::vector<fd_iter_count_t>();
+		} else {
+			wideData_.resize(size_, 0);
+			compactData_ = std::vector<uint16_t>();
+		}
+	}
+
+	bool isCompact() const {
+		return compact_;
+	}
+
+	size_t size() const {
+		return size_;
+	}
+
+	const uint16_t* compact() const {
+		return compactData_.data();
+	}
+
+	const fd_iter_count_t* wide() const {
+		return wideData_.data();
+	}
+
+	fd_iter_count_t operator[](const size_t& i) const {
+		return compact_ ? compactData_[i] : wideData_[i];
+	}
+
+	void store(const size_t& offset, const fd_iter_count_t* iterations, const size_t& size) {
+		if (compact_)
+			std::copy(iterations, iterations + size, compactData_.begin() + offset);
+		else
+			std::copy(iterations, iterations + size, wideData_.begin() + offset);
+	}
+
+	//copies size counts from offset "from" to offset "to". the ranges must not overlap.
+	void copy(const size_t& to, const size_t& from, const size_t& size) {
+		if (compact_)
+			std::copy(compactData_.begin() + from, compactData_.begin() + from + size, compactData_.begin() + to);
+		else
+			std::copy(wideData_.begin() + from, wideData_.begin() + from + size, wideData_.begin() + to);
+	}
+
+	void swap(IterationBuffer& other) {
+		std::swap(size_, other.size_);
+		std::swap(compact_, other.compact_);
+		compactData_.swap(other.compactData_);
+		wideData_.swap(other.wideData_);
+	}
+};
+
+} /* namespace fractaldive */
+
+#endif /* SRC_ITERATIONBUFFER_HPP_ */
@@ -0,0 +1,1030 @@
+#ifndef SRC_KERNEL_HPP_
+#define SRC_KERNEL_HPP_
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+#include <limits>
+#include <cmath>
+
+#include "types.hpp"
+#include "formula.hpp"
+
+#if defined(_FIXEDPOINT) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#endif
+
+namespace fractaldive {
+
+//the kernels are forced inline so that all of their code ends up in the (target specific) function instantiating them
+#define FD_KERNEL_INLINE inline __attribute__((always_inline))
+
+//tolerance of the periodicity check. for floating point types a few ulps of a value of magnitude 1, for fixed point
+//types exactly one ulp.
+template<typename T>
+struct Periodicity {
+	static T epsilon() {
+		return std::numeric_limits<T>::epsilon() * T(64.0);
+	}
+};
+
+#ifdef _FIXEDPOINT
+template<class BaseType, class OverflowType, uint8_t numFracBits>
+struct Periodicity<mn::MFixedPoint::FpF<BaseType, OverflowType, numFracBits>> {
+	static mn::MFixedPoint::FpF<BaseType, OverflowType, numFracBits> epsilon() {
+		return mn::MFixedPoint::FpF<BaseType, OverflowType, numFracBits>(1.0 / double(BaseType(1) << numFracBits));
+	}
+};
+#endif
+
+#ifdef __SIZEOF_INT128__
+//one ulp of a multi-limb type is far below what an attracting cycle converges to in a reasonable number of iterations.
+//use the same number of ulps as for floating point types.
+template<uint8_t numLimbs, uint16_t numFracBits>
+struct Periodicity<mn::MFixedPoint::FpM<numLimbs, numFracBits>> {
+	static mn::MFixedPoint::FpM<numLimbs, numFracBits> epsilon() {
+		return mn::MFixedPoint::FpM<numLimbs, numFracBits>(std::ldexp(1.0, 6 - numFracBits));
+	}
+};
+#endif
+
+//the orbit is only compared with the saved point every FD_PERIODICITY_CHECK iterations. a cycle is still found once the
+//distance between two checkpoints is at least FD_PERIODICITY_CHECK times its period, at a fraction of the cost.
+#ifndef FD_PERIODICITY_CHECK
+#define FD_PERIODICITY_CHECK 8
+#endif
+
+template<typename T>
+inline T fd_abs(const T& n) {
+	return n < T(0.0) ? -n : n;
+}
+
+template<typename T>
+inline T fd_sqr(const T& n) {
+	return n * n;
+}
+
+#ifdef __SIZEOF_INT128__
+template<uint8_t numLimbs, uint16_t numFracBits>
+inline mn::MFixedPoint::FpM<numLimbs, numFracBits> fd_sqr(const mn::MFixedPoint::FpM<numLimbs, numFracBits>& n) {
+	return n.Square();
+}
+#endif
+
+//analytic interior test: main cardioid and period-2 bulb
+template<typename T>
+inline bool is_main_cardioid_or_bulb(const T& pointr, const T& pointi) {
+	const T quarter = 0.25;
+	const T xq = pointr - quarter;
+	const T pisqr = fd_sqr(pointi);
+	const T q = fd_sqr(xq) + pisqr;
+	if (q * (q + xq) <= quarter * pisqr)
+		return true;
+
+	const T xb = pointr + T(1.0);
+	return fd_sqr(xb) + pisqr <= T(0.0625);
+}
+
+//the iteration steps of the formulas (see formula.hpp) the kernels are instantiated with. they apply to scalars and
+//to vectors of the gcc vector extensions alike and get the squares of z, which the escape test needs anyway, so every
+//formula gets by with as few multiplications as z^2 + c.
+//CARDIOID: the main cardioid/period-2 bulb test applies. JULIA: z starts at the pixel and c is the constant of
+//FormulaParams.
+struct Mandelbrot {
+	static constexpr bool CARDIOID = true;
+	static constexpr bool JULIA = false;
+
+	//Algebraically optimized version that uses addition/subtraction as often as possible while reducing multiplications
+	//and limiting multiplications to squaring only. this pretty nicely compiles to asm on Linux x86_64 (+simd), WASM (+simd) and m68k (000/020/030)
+	//because types are chosen very carefully in "types.hpp"
+	template<typename V>
+	static FD_KERNEL_INLINE void step(V& zr, V& zi, const V& zrsqr, const V& zisqr, const V& cr, const V& ci) {
+		//zi = (square(zr + zi) - zrsqr) - zisqr; //equals line below as a consequence of binomial expansion
+		zi = (zr + zr) * zi;
+		zi += ci;
+		zr = (zrsqr - zisqr) + cr;
+	}
+};
+
+struct Julia {
+	static constexpr bool CARDIOID = false;
+	static constexpr bool JULIA = true;
+
+	template<typename V>
+	static FD_KERNEL_INLINE void step(V& zr, V& zi, const V& zrsqr, const V& zisqr, const V& cr, const V& ci) {
+		Mandelbrot::step(zr, zi, zrsqr, zisqr, cr, ci);
+	}
+};
+
+//2|re z||im z| equals |2 re z im z|, so only the imaginary part needs an absolute value
+struct BurningShip {
+	static constexpr bool CARDIOID = false;
+	static constexpr bool JULIA = false;
+
+	template<typename V>
+	static FD_KERNEL_INLINE void step(V& zr, V& zi, const V& zrsqr, const V& zisqr, const V& cr, const V& ci) {
+		zi = (zr + zr) * zi;
+		zi = zi < V { } ? -zi : zi;
+		zi += ci;
+		zr = (zrsqr - zisqr) + cr;
+	}
+};
+
+//z^N: z^2 from the squares, z^3 expanded, other even powers by squaring z^(N/2) and other odd powers as z^(N-1) * z
+template<unsigned N, bool Odd = (N % 2) == 1>
+struct ComplexPower;
+
+template<>
+struct ComplexPower<2, false> {
+	template<typename V>
+	static FD_KERNEL_INLINE void apply(const V& zr, const V& zi, const V& zrsqr, const V& zisqr, V& pr, V& pi) {
+		pr = zrsqr - zisqr;
+		pi = (zr + zr) * zi;
+	}
+};
+
+template<>
+struct ComplexPower<3, true> {
+	template<typename V>
+	static FD_KERNEL_INLINE void apply(const V& zr, const V& zi, const V& zrsqr, const V& zisqr, V& pr, V& pi) {
+		pr = zr * (zrsqr - (zisqr + zisqr + zisqr));
+		pi = zi * ((zrsqr + zrsqr + zrsqr) - zisqr);
+	}
+};
+
+template<unsigned N>
+struct ComplexPower<N, false> {
+	template<typename V>
+	static FD_KERNEL_INLINE void apply(const V& zr, const V& zi, const V& zrsqr, const V& zisqr, V& pr, V& pi) {
+		V hr, hi;
+		ComplexPower<N / 2>::apply(zr, zi, zrsqr, zisqr, hr, hi);
+		pr = hr * hr - hi * hi;
+		pi = (hr + hr) * hi;
+	}
+};
+
+template<unsigned N>
+struct ComplexPower<N, true> {
+	template<typename V>
+	static FD_KERNEL_INLINE void apply(const V& zr, const V& zi, const V& zrsqr, const V& zisqr, V& pr, V& pi) {
+		V hr, hi;
+		ComplexPower<N - 1>::apply(zr, zi, zrsqr, zisqr, hr, hi);
+		pr = hr * zr - hi * zi;
+		pi = hr * zi + hi * zr;
+	}
+};
+
+template<unsigned N>
+struct Multibrot {
+	static_assert(N >= 2, "the power of a multibrot set has to be at least 2");
+	static constexpr bool CARDIOID = N == 2;
+	static constexpr bool JULIA = false;
+
+	template<typename V>
+	static FD_KERNEL_INLINE void step(V& zr, V& zi, const V& zrsqr, const V& zisqr, const V& cr, const V& ci) {
+		V pr, pi;
+		ComplexPower<N>::apply(zr, zi, zrsqr, zisqr, pr, pi);
+		zr = pr + cr;
+		zi = pi + ci;
+	}
+};
+
+//the start of the orbit of a point: z = 0 and c = point, or the other way round with c the julia constant
+template<typename T, typename F>
+FD_KERNEL_INLINE void formula_start(const T& pointr, const T& pointi, const FormulaParams& params, T& zr, T& zi, T& cr, T& ci) {
+	if (F::JULIA) {
+		zr = pointr;
+		zi = pointi;
+		cr = T(params.juliar_);
+		ci = T(params.juliai_);
+	} else {
+		zr = zi = T { };
+		cr = pointr;
+		ci = pointi;
+	}
+}
+
+//iterates a single point with formula F. instantiated for every floating point type of the precision ladder (see
+//precision.cpp) and for the fixed point types.
+template<typename T, typename F = Mandelbrot>
+inline fd_iter_count_t mandelbrot_point(const T& pointr, const T& pointi, const fd_iter_count_t& currentIt, const bool& checkInterior, const FormulaParams& params = FormulaParams()) {
+	fd_iter_count_t iterations = 0;
+	T zr, zi, cr, ci;
+	formula_start<T, F>(pointr, pointi, params, zr, zi, cr, ci);
+	T zrsqr = fd_sqr(zr);
+	T zisqr = fd_sqr(zi);
+	const T four = 4.0;
+
+	//skip points that are known to be in the set and bail out on orbits that run into a cycle
+	if (checkInterior && F::CARDIOID && is_main_cardioid_or_bulb<T>(pointr, pointi))
+		return currentIt;
+	const T epsilon = Periodicity<T>::epsilon();
+	T savedr = 0.0, savedi = 0.0;
+	fd_iter_count_t checkpoint = 1;
+
+	while (iterations < currentIt && zrsqr + zisqr <= four) {
+		F::step(zr, zi, zrsqr, zisqr, cr, ci);
+
+		zrsqr = fd_sqr(zr);
+		zisqr = fd_sqr(zi);
+
+		++iterations;
+
+		if (checkInterior) {
+			if ((iterations % FD_PERIODICITY_CHECK) == 0 && fd_abs(zr - savedr) <= epsilon && fd_abs(zi - savedi) <= epsilon)
+				return currentIt;
+			if (iterations == checkpoint) {
+				savedr = zr;
+				savedi = zi;
+				checkpoint <<= 1;
+			}
+		}
+	}
+	return iterations;
+}
+
+//mandelbrot_point with the escape check unrolled: blocks of Unroll iterations run without a branch and only remember
+//whether the orbit escaped on the way. a block it escaped in is replayed from the state saved at its start with the
+//checks of mandelbrot_point, so the iteration counts are bit-identical (for floating point types only without
+//-ffast-math, which lets the compiler reassociate each loop differently). the first block and the remainder that doesn't
+//fill a block are iterated checked as well. since Unroll divides FD_PERIODICITY_CHECK, the periodicity checks and
+//the checkpoints after the first block fall on block boundaries and see the same orbit values.
+template<typename T, size_t Unroll, typename F = Mandelbrot>
+inline fd_iter_count_t mandelbrot_point_unrolled(const T& pointr, const T& pointi, const fd_iter_count_t& currentIt, const bool& checkInterior, const FormulaParams& params = FormulaParams()) {
+	static_assert(Unroll > 0 && FD_PERIODICITY_CHECK % Unroll == 0 && (Unroll & (Unroll - 1)) == 0, "Unroll must be a power of two dividing FD_PERIODICITY_CHECK");
+	fd_iter_count_t iterations = 0;
+	T zr, zi, cr, ci;
+	formula_start<T, F>(pointr, pointi, params, zr, zi, cr, ci);
+	T zrsqr = fd_sqr(zr);
+	T zisqr = fd_sqr(zi);
+	const T four = 4.0;
+
+	if (checkInterior && F::CARDIOID && is_main_cardioid_or_bulb<T>(pointr, pointi))
+		return currentIt;
+	const T epsilon = Periodicity<T>::epsilon();
+	T savedr = 0.0, savedi = 0.0;
+	fd_iter_count_t checkpoint = 1;
+	fd_iter_count_t checkedEnd = std::min(fd_iter_count_t(Unroll), currentIt);
+
+	for (;;) {
+		while (iterations < checkedEnd && zrsqr + zisqr <= four) {
+			F::step(zr, zi, zrsqr, zisqr, cr, ci);
+
+			zrsqr = fd_sqr(zr);
+			zisqr = fd_sqr(zi);
+
+			++iterations;
+
+			if (checkInterior) {
+				if ((iterations % FD_PERIODICITY_CHECK) == 0 && fd_abs(zr - savedr) <= epsilon && fd_abs(zi - savedi) <= epsilon)
+					return currentIt;
+				if (iterations == checkpoint) {
+					savedr = zr;
+					savedi = zi;
+					checkpoint <<= 1;
+				}
+			}
+		}
+
+		if (iterations >= currentIt || !(zrsqr + zisqr <= four))
+			return iterations;
+
+		if (currentIt - iterations < Unroll) {
+			checkedEnd = currentIt;
+			continue;
+		}
+
+		const T blockr = zr, blocki = zi;
+		const T blockrsqr = zrsqr, blockisqr = zisqr;
+		bool escaped = false;
+		for (size_t i = 0; i < Unroll; ++i) {
+			F::step(zr, zi, zrsqr, zisqr, cr, ci);
+
+			zrsqr = fd_sqr(zr);
+			zisqr = fd_sqr(zi);
+			escaped |= !(zrsqr + zisqr <= four);
+		}
+
+		if (escaped) {
+			//replay the block checked
+			zr = blockr;
+			zi = blocki;
+			zrsqr = blockrsqr;
+			zisqr = blockisqr;
+			checkedEnd = iterations + Unroll;
+			continue;
+		}
+
+		iterations += Unroll;
+		if (checkInterior) {
+			if ((iterations % FD_PERIODICITY_CHECK) == 0 && fd_abs(zr - savedr) <= epsilon && fd_abs(zi - savedi) <= epsilon)
+				return currentIt;
+			if (iterations == checkpoint) {
+				savedr = zr;
+				savedi = zi;
+				checkpoint <<= 1;
+			}
+		}
+	}
+}
+
+//runs mandelbrot_point_unrolled with an unroll factor selected at runtime (1, 2, 4 or 8). 1 is mandelbrot_point.
+template<typename T, typename F = Mandelbrot>
+inline fd_iter_count_t mandelbrot_point_unroll(const size_t& unroll, const T& pointr, const T& pointi, const fd_iter_count_t& currentIt, const bool& checkInterior, const FormulaParams& params = FormulaParams()) {
+	switch (unroll) {
+	case 8:
+		return mandelbrot_point_unrolled<T, 8, F>(pointr, pointi, currentIt, checkInterior, params);
+	case 4:
+		return mandelbrot_point_unrolled<T, 4, F>(pointr, pointi, currentIt, checkInterior, params);
+	case 2:
+		return mandelbrot_point_unrolled<T, 2, F>(pointr, pointi, currentIt, checkInterior, params);
+	default:
+		return mandelbrot_point<T, F>(pointr, pointi, currentIt, checkInterior, params);
+	}
+}
+
+//runs mandelbrot_point_unroll with the policy of a formula selected at runtime. the switch is outside of the loop.
+template<typename T>
+inline fd_iter_count_t formula_point(const Formula& formula, const FormulaParams& params, const size_t& unroll, const T& pointr, const T& pointi, const fd_iter_count_t& currentIt, const bool& checkInterior) {
+	switch (formula) {
+	case FORMULA_JULIA:
+		return mandelbrot_point_unroll<T, Julia>(unroll, pointr, pointi, currentIt, checkInterior, params);
+	case FORMULA_BURNING_SHIP:
+		return mandelbrot_point_unroll<T, BurningShip>(unroll, pointr, pointi, currentIt, checkInterior, params);
+	case FORMULA_MULTIBROT3:
+		return mandelbrot_point_unroll<T, Multibrot<3>>(unroll, pointr, pointi, currentIt, checkInterior, params);
+	case FORMULA_MULTIBROT4:
+		return mandelbrot_point_unroll<T, Multibrot<4>>(unroll, pointr, pointi, currentIt, checkInterior, params);
+	default:
+		return mandelbrot_point_unroll<T, Mandelbrot>(unroll, pointr, pointi, currentIt, checkInterior, params);
+	}
+}
+
+//an escaped orbit is continued for FD_DISTANCE_STEPS uncounted steps, so |z| is large enough for a good distance estimate
+#define FD_DISTANCE_STEPS 4
+//the squared magnitude of dz/dz under which an orbit is taken to be attracted by a cycle
+#define FD_DERIVATIVE_BAILOUT 1e-24
+
+//mandelbrot_point that also tracks the derivatives of the orbit. dz/dc (dz/dz0 for julia sets) gives the distance of
+//an escaped point to the boundary of the set, |z| ln|z| / |dz|, in units of the complex plane. interior points have a
+//distance of 0. with checkInterior set, the derivative with respect to z doubles as an early bailout: it shrinks
+//geometrically once the orbit is attracted by a cycle, long before the periodicity check finds the cycle.
+//the derivatives are those of z^2 + c, so F is Mandelbrot or Julia (see has_distance_estimate()).
+template<typename T, typename F = Mandelbrot>
+inline fd_iter_count_t mandelbrot_point_distance(const T& pointr, const T& pointi, const fd_iter_count_t& currentIt, const bool& checkInterior, const FormulaParams& params, T& distance) {
+	fd_iter_count_t iterations = 0;
+	T zr, zi, cr, ci;
+	formula_start<T, F>(pointr, pointi, params, zr, zi, cr, ci);
+	T zrsqr = fd_sqr(zr);
+	T zisqr = fd_sqr(zi);
+	const T four = 4.0;
+	const T bailout = FD_DERIVATIVE_BAILOUT;
+	distance = 0;
+
+	if (checkInterior && F::CARDIOID && is_main_cardioid_or_bulb<T>(pointr, pointi))
+		return currentIt;
+	const T epsilon = Periodicity<T>::epsilon();
+	T savedr = 0.0, savedi = 0.0;
+	fd_iter_count_t checkpoint = 1;
+	//dz/dc (dz/dz0) and dz/dz since the first step that doesn't start at z = 0
+	T dr = F::JULIA ? 1.0 : 0.0, di = 0.0;
+	T pr = 1.0, pi = 0.0;
+	const T one = F::JULIA ? 0.0 : 1.0;
+
+	while (iterations < currentIt && zrsqr + zisqr <= four) {
+		const T ndr = 2 * (zr * dr - zi * di) + one;
+		di = 2 * (zr * di + zi * dr);
+		dr = ndr;
+		if (checkInterior && (F::JULIA || iterations > 0)) {
+			const T npr = 2 * (zr * pr - zi * pi);
+			pi = 2 * (zr * pi + zi * pr);
+			pr = npr;
+			if (pr * pr + pi * pi < bailout)
+				return currentIt;
+		}
+		F::step(zr, zi, zrsqr, zisqr, cr, ci);
+
+		zrsqr = fd_sqr(zr);
+		zisqr = fd_sqr(zi);
+
+		++iterations;
+
+		if (checkInterior) {
+			if ((iterations % FD_PERIODICITY_CHECK) == 0 && fd_abs(zr - savedr) <= epsilon && fd_abs(zi - savedi) <= epsilon)
+				return currentIt;
+			if (iterations == checkpoint) {
+				savedr = zr;
+				savedi = zi;
+				checkpoint <<= 1;
+			}
+		}
+	}
+	if (iterations == currentIt)
+		return iterations;
+
+	for (size_t i = 0; i < FD_DISTANCE_STEPS; ++i) {
+		const T ndr = 2 * (zr * dr - zi * di) + one;
+		di = 2 * (zr * di + zi * dr);
+		dr = ndr;
+		F::step(zr, zi, zrsqr, zisqr, cr, ci);
+		zrsqr = fd_sqr(zr);
+		zisqr = fd_sqr(zi);
+	}
+	const T z = std::sqrt(zrsqr + zisqr);
+	const T dz = std::sqrt(dr * dr + di * di);
+	if (dz > 0)
+		distance = z * std::log(z) / dz;
+	return iterations;
+}
+
+//runs mandelbrot_point_distance with the policy of a formula selected at runtime
+template<typename T>
+inline fd_iter_count_t formula_point_distance(const Formula& formula, const FormulaParams& params, const T& pointr, const T& pointi, const fd_iter_count_t& currentIt, const bool& checkInterior, T& distance) {
+	if (formula == FORMULA_JULIA)
+		return mandelbrot_point_distance<T, Julia>(pointr, pointi, currentIt, checkInterior, params, distance);
+	return mandelbrot_point_distance<T, Mandelbrot>(pointr, pointi, currentIt, checkInterior, params, distance);
+}
+
+//persistent lanes kernels check for lanes to refill every FD_PERSISTENT_CHECK steps
+#ifndef FD_PERSISTENT_CHECK
+#define FD_PERSISTENT_CHECK 4
+#endif
+
+//iterations actually computed by active lanes vs. lane slots spent
+struct LaneStats {
+	uint64_t iterations_ = 0;
+	uint64_t slots_ = 0;
+};
+
+#ifndef _FIXEDPOINT
+//width of the native vector registers the build targets. dispatch.cpp additionally instantiates the kernels for wider
+//registers and selects them at runtime.
+#if defined(__AVX512F__)
+constexpr size_t FD_SIMD_BYTES = 64;
+#elif defined(__AVX__)
+constexpr size_t FD_SIMD_BYTES = 32;
+#else
+constexpr size_t FD_SIMD_BYTES = 16;
+#endif
+
+//lane-parallel escape time kernels using the gcc/clang vector extensions. that way the same code compiles to
+//SSE2/AVX2/AVX-512 on x86, NEON on arm and simd128 on WASM depending on the target flags.
+//"Lanes" are split into blocks of native vectors because wider generic vectors are lowered to scalar code
+//(e.g. the comparisons) and multiple blocks give the cpu independent dependency chains to work on.
+template<typename T, size_t Lanes, size_t Bytes = FD_SIMD_BYTES>
+struct SimdTraits {
+	static constexpr size_t BYTES = (Lanes * sizeof(T) < Bytes) ? Lanes * sizeof(T) : Bytes;
+	static constexpr size_t WIDTH = BYTES / sizeof(T);
+	static constexpr size_t BLOCKS = Lanes / WIDTH;
+	typedef typename std::conditional<sizeof(T) == 8, int64_t, int32_t>::type mask_t;
+	typedef T float_v __attribute__((vector_size(BYTES)));
+	typedef mask_t mask_v __attribute__((vector_size(BYTES)));
+};
+
+template<typename T, size_t Lanes, size_t Bytes = FD_SIMD_BYTES>
+FD_KERNEL_INLINE bool any_lane(const typename SimdTraits<T, Lanes, Bytes>::mask_v* mask) {
+	typedef SimdTraits<T, Lanes, Bytes> simd;
+	typename simd::mask_v any = mask[0];
+	for (size_t b = 1; b < simd::BLOCKS; ++b)
+		any |= mask[b];
+
+	uint64_t words[simd::BYTES / sizeof(uint64_t)];
+	memcpy(words, &any, sizeof(words));
+	uint64_t result = 0;
+	for (size_t i = 0; i < simd::BYTES / sizeof(uint64_t); ++i)
+		result |= words[i];
+	return result != 0;
+}
+
+//iterates exactly "Lanes" points at once. the points are given as C and rounded to T (e.g. double coordinates
+//iterated as float). lanes that escaped are masked out of the iteration count but keep being
+//iterated until all lanes escaped or currentIt is reached.
+//if checkInterior is set, points inside the main cardioid or the period-2 bulb are rejected up front (if the formula F
+//has them) and lanes whose orbit runs into a cycle (brent-style: compare with the orbit saved at power-of-two steps)
+//stop early. both are counted as currentIt, the same result as iterating them to the end.
+template<typename T, size_t Lanes, size_t Bytes = FD_SIMD_BYTES, typename C = T, typename F = Mandelbrot>
+FD_KERNEL_INLINE void mandelbrot_lanes(const C* pointr, const C* pointi, fd_iter_count_t* iterations, const fd_iter_count_t& currentIt, const bool& checkInterior, const FormulaParams& params, LaneStats& stats) {
+	typedef SimdTraits<T, Lanes, Bytes> simd;
+	typedef typename simd::float_v float_v;
+	typedef typename simd::mask_v mask_v;
+	constexpr size_t BLOCKS = simd::BLOCKS;
+
+	float_v cr[BLOCKS], ci[BLOCKS];
+	float_v zr[BLOCKS], zi[BLOCKS];
+	float_v zrsqr[BLOCKS], zisqr[BLOCKS];
+	float_v savedr[BLOCKS], savedi[BLOCKS];
+	mask_v count[BLOCKS], active[BLOCKS], work[BLOCKS];
+	const float_v four = float_v { } + T(4.0);
+	const T epsilon = Periodicity<T>::epsilon();
+	const mask_v epsilonBits = (mask_v) (float_v { } + epsilon);
+	const mask_v magnitude = mask_v { } + std::numeric_limits<typename simd::mask_t>::max();
+	const mask_v maxIt = mask_v { } + currentIt;
+
+	if (std::is_same<T, C>::value) {
+		memcpy(cr, pointr, sizeof(cr));
+		memcpy(ci, pointi, sizeof(ci));
+	} else {
+		for (size_t l = 0; l < Lanes; ++l) {
+			cr[l / simd::WIDTH][l % simd::WIDTH] = pointr[l];
+			ci[l / simd::WIDTH][l % simd::WIDTH] = pointi[l];
+		}
+	}
+	for (size_t b = 0; b < BLOCKS; ++b) {
+		zr[b] = zi[b] = zrsqr[b] = zisqr[b] = float_v { };
+		if (F::JULIA) {
+			zr[b] = cr[b];
+			zi[b] = ci[b];
+			zrsqr[b] = zr[b] * zr[b];
+			zisqr[b] = zi[b] * zi[b];
+			cr[b] = float_v { } + T(params.juliar_);
+			ci[b] = float_v { } + T(params.juliai_);
+		}
+		savedr[b] = savedi[b] = float_v { };
+		count[b] = work[b] = mask_v { };
+		active[b] = (zrsqr[b] + zisqr[b] <= four);
+		if (checkInterior && F::CARDIOID) {
+			const float_v xq = cr[b] - T(0.25);
+			const float_v cisqr = ci[b] * ci[b];
+			const float_v q = xq * xq + cisqr;
+			const float_v xb = cr[b] + T(1.0);
+			const mask_v interior = (q * (q + xq) <= T(0.25) * cisqr) | (xb * xb + cisqr <= T(0.0625));
+			count[b] = interior & maxIt;
+			active[b] &= ~interior;
+		}
+	}
+
+	fd_iter_count_t steps = 0;
+	fd_iter_count_t checkpoint = 1;
+	for (; steps < currentIt && any_lane<T, Lanes, Bytes>(active); ++steps) {
+		for (size_t b = 0; b < BLOCKS; ++b) {
+			F::step(zr[b], zi[b], zrsqr[b], zisqr[b], cr[b], ci[b]);
+
+			zrsqr[b] = zr[b] * zr[b];
+			zisqr[b] = zi[b] * zi[b];
+
+			//active lanes are -1
+			count[b] -= active[b];
+			work[b] -= active[b];
+			active[b] &= (zrsqr[b] + zisqr[b] <= four);
+		}
+
+		//same schedule and criterion as mandelbrot_point(): every FD_PERIODICITY_CHECK iterations, per component
+		if (checkInterior && ((steps + 1) % FD_PERIODICITY_CHECK) == 0) {
+			for (size_t b = 0; b < BLOCKS; ++b) {
+				//|dr| <= epsilon && |di| <= epsilon with a single compare: non negative floats order like their bit
+				//patterns, so both hold iff neither epsilon - |dr| nor epsilon - |di| (as integers) is negative.
+				const mask_v dr = (mask_v) (zr[b] - savedr[b]) & magnitude;
+				const mask_v di = (mask_v) (zi[b] - savedi[b]) & magnitude;
+				const mask_v periodic = active[b] & (((epsilonBits - dr) | (epsilonBits - di)) >= mask_v { });
+				count[b] = (count[b] & ~periodic) | (maxIt & periodic);
+				active[b] &= ~periodic;
+			}
+
+		}
+
+		if (checkInterior && steps + 1 == checkpoint) {
+			for (size_t b = 0; b < BLOCKS; ++b) {
+				savedr[b] = zr[b];
+				savedi[b] = zi[b];
+			}
+			checkpoint <<= 1;
+		}
+	}
+
+	for (size_t b = 0; b < BLOCKS; ++b) {
+		for (size_t i = 0; i < simd::WIDTH; ++i) {
+			iterations[b * simd::WIDTH + i] = count[b][i];
+			stats.iterations_ += work[b][i];
+		}
+	}
+	stats.slots_ += uint64_t(steps) * Lanes;
+}
+
+//iterates a span of points in batches of "Lanes". the tail is padded with the last point.
+template<typename T, size_t Lanes, size_t Bytes = FD_SIMD_BYTES, typename C = T, typename F = Mandelbrot>
+FD_KERNEL_INLINE void mandelbrot_simd(const C* pointr, const C* pointi, fd_iter_count_t* iterations, const size_t& size, const fd_iter_count_t& currentIt, const bool& checkInterior, const FormulaParams& params, LaneStats& stats) {
+	size_t i = 0;
+	for (; i + Lanes <= size; i += Lanes) {
+		mandelbrot_lanes<T, Lanes, Bytes, C, F>(pointr + i, pointi + i, iterations + i, currentIt, checkInterior, params, stats);
+	}
+
+	if (i < size) {
+		C tailr[Lanes];
+		C taili[Lanes];
+		fd_iter_count_t tailIterations[Lanes];
+		for (size_t j = 0; j < Lanes; ++j) {
+			size_t k = std::min(i + j, size - 1);
+			tailr[j] = pointr[k];
+			taili[j] = pointi[k];
+		}
+		mandelbrot_lanes<T, Lanes, Bytes, C, F>(tailr, taili, tailIterations, currentIt, checkInterior, params, stats);
+		memcpy(iterations + i, tailIterations, (size - i) * sizeof(fd_iter_count_t));
+	}
+}
+
+//"persistent lanes": iterates the pixels of a block of rows (row-major) and whenever a lane escapes or reaches
+//currentIt its count is written and the lane is refilled with the next pixel from the queue, so the vector units stay
+//busy until the queue is drained instead of waiting for the slowest lane of each batch.
+//pointr holds one value per column and pointi one value per row.
+//with checkInterior set, points in the main cardioid or the period-2 bulb (if the formula F has them) never enter a lane.
+template<typename T, size_t Lanes, size_t Bytes = FD_SIMD_BYTES, typename C = T, typename F = Mandelbrot>
+FD_KERNEL_INLINE void mandelbrot_persistent(const C* pointr, const C* pointi, const size_t& width, const size_t& rows, fd_iter_count_t* iterations, const fd_iter_count_t& currentIt, const bool& checkInterior, const FormulaParams& params, LaneStats& stats) {
+	typedef SimdTraits<T, Lanes, Bytes> simd;
+	typedef typename simd::float_v float_v;
+	typedef typename simd::mask_v mask_v;
+	constexpr size_t BLOCKS = simd::BLOCKS;
+	constexpr size_t WIDTH = simd::WIDTH;
+
+	float_v cr[BLOCKS], ci[BLOCKS];
+	float_v zr[BLOCKS], zi[BLOCKS];
+	float_v zrsqr[BLOCKS], zisqr[BLOCKS];
+	mask_v count[BLOCKS], active[BLOCKS], occupied[BLOCKS];
+	//the pixel index and the step at which it entered the lane
+	size_t pixel[Lanes] = { };
+	uint64_t start[Lanes] = { };
+	const float_v four = float_v { } + T(4.0);
+	const size_t size = width * rows;
+
+	size_t next = 0;
+	uint64_t steps = 0;
+	uint64_t deadline = UINT64_MAX;
+
+	for (size_t b = 0; b < BLOCKS; ++b) {
+		zr[b] = zi[b] = zrsqr[b] = zisqr[b] = float_v { };
+		cr[b] = ci[b] = float_v { };
+		if (F::JULIA) {
+			cr[b] += T(params.juliar_);
+			ci[b] += T(params.juliai_);
+		}
+		count[b] = active[b] = occupied[b] = mask_v { };
+	}
+
+	for (;;) {
+		//refill lanes that escaped, reached currentIt or were never filled
+		for (size_t b = 0; b < BLOCKS; ++b) {
+			for (size_t l = 0; l < WIDTH; ++l) {
+				const size_t lane = b * WIDTH + l;
+				if (occupied[b][l]) {
+					if (active[b][l] && (steps - start[lane]) < currentIt)
+						continue;
+					iterations[pixel[lane]] = count[b][l];
+					stats.iterations_ += count[b][l];
+				}
+
+				if (checkInterior && F::CARDIOID) {
+					while (next < size && is_main_cardioid_or_bulb(pointr[next % width], pointi[next / width])) {
+						iterations[next] = currentIt;
+						++next;
+					}
+				}
+
+				if (next < size) {
+					pixel[lane] = next;
+					start[lane] = steps;
+					if (F::JULIA) {
+						//points that start outside of the escape radius leave the lane at the next check with 0 iterations
+						const T r = pointr[next % width];
+						const T i = pointi[next / width];
+						zr[b][l] = r;
+						zi[b][l] = i;
+						zrsqr[b][l] = r * r;
+						zisqr[b][l] = i * i;
+						active[b][l] = r * r + i * i <= T(4.0) ? -1 : 0;
+					} else {
+						cr[b][l] = pointr[next % width];
+						ci[b][l] = pointi[next / width];
+						zr[b][l] = zi[b][l] = zrsqr[b][l] = zisqr[b][l] = 0;
+						active[b][l] = -1;
+					}
+					count[b][l] = 0;
+					occupied[b][l] = -1;
+					++next;
+				} else {
+					active[b][l] = occupied[b][l] = 0;
+				}
+			}
+		}
+
+		if (!any_lane<T, Lanes, Bytes>(occupied))
+			break;
+
+		deadline = UINT64_MAX;
+		for (size_t lane = 0; lane < Lanes; ++lane) {
+			if (occupied[lane / WIDTH][lane % WIDTH])
+				deadline = std::min(deadline, start[lane] + currentIt);
+		}
+
+		//iterate until a lane escapes or the oldest lane reaches currentIt. escapes are only checked every
+		//FD_PERSISTENT_CHECK steps because a refill costs a scalar pass over all lanes.
+		mask_v escaped[BLOCKS];
+		do {
+			const uint64_t batch = std::min(uint64_t(FD_PERSISTENT_CHECK), deadline - steps);
+			for (uint64_t i = 0; i < batch; ++i) {
+				for (size_t b = 0; b < BLOCKS; ++b) {
+					F::step(zr[b], zi[b], zrsqr[b], zisqr[b], cr[b], ci[b]);
+
+					zrsqr[b] = zr[b] * zr[b];
+					zisqr[b] = zi[b] * zi[b];
+
+					count[b] -= active[b];
+					active[b] &= (zrsqr[b] + zisqr[b] <= four);
+				}
+			}
+			steps += batch;
+			for (size_t b = 0; b < BLOCKS; ++b)
+				escaped[b] = occupied[b] ^ active[b];
+		} while (steps < deadline && !any_lane<T, Lanes, Bytes>(escaped));
+	}
+
+	stats.slots_ += steps * Lanes;
+}
+#endif
+
+#if defined(_FIXEDPOINT) && !defined(_FIXEDPOINT_LIMBS) && (defined(__x86_64__) || defined(__i386__))
+#define FD_FIXED_SIMD
+
+//the raw representation of the FpF types
+template<typename T>
+struct FixedPointTraits;
+
+template<class BaseType, class OverflowType, uint8_t numFracBits>
+struct FixedPointTraits<mn::MFixedPoint::FpF<BaseType, OverflowType, numFracBits>> {
+	typedef BaseType raw_t;
+	static constexpr uint8_t FRAC_BITS = numFracBits;
+};
+
+//integer simd kernel for the 32-bit Q-format of the fixed point build. every 64-bit element of a register holds the raw
+//value of one lane in its lower 32 bits: vpmuldq multiplies 4 lanes at once into 64-bit products and their bits
+//[FRAC_BITS, FRAC_BITS + 32) are exactly the truncated result of FpFMultiply. additions and comparisons only look at the
+//lower 32 bits, so they wrap around like the scalar int32_t arithmetic.
+//the interior and periodicity checks follow mandelbrot_point, so the iteration counts are the same as the scalar ones.
+//there is no formula policy for the integer kernels, they only iterate the mandelbrot set.
+template<typename T, size_t Lanes>
+__attribute__((target("avx2"))) void mandelbrot_fixed_lanes(const T* pointr, const T* pointi, fd_iter_count_t* iterations, const fd_iter_count_t& currentIt, const bool& checkInterior, LaneStats& stats) {
+	typedef FixedPointTraits<T> traits;
+	static_assert(std::is_same<typename traits::raw_t, int32_t>::value, "the fixed point simd kernel needs 32-bit raw values");
+	constexpr size_t WIDTH = 4;
+	constexpr size_t BLOCKS = Lanes / WIDTH;
+	constexpr int FRAC_BITS = traits::FRAC_BITS;
+
+	__m256i cr[BLOCKS], ci[BLOCKS];
+	__m256i zr[BLOCKS], zi[BLOCKS];
+	__m256i zrsqr[BLOCKS], zisqr[BLOCKS];
+	__m256i savedr[BLOCKS], savedi[BLOCKS];
+	__m256i count[BLOCKS], active[BLOCKS], work[BLOCKS];
+	const __m256i four = _mm256_set1_epi32(T(4.0).GetRawVal());
+	const __m256i epsilon = _mm256_set1_epi32(Periodicity<T>::epsilon().GetRawVal());
+	const __m256i minusEpsilon = _mm256_set1_epi32(-Periodicity<T>::epsilon().GetRawVal());
+	const __m256i maxIt = _mm256_set1_epi32(currentIt);
+
+	for (size_t b = 0; b < BLOCKS; ++b) {
+		int64_t r[WIDTH], i[WIDTH], interior[WIDTH];
+		for (size_t l = 0; l < WIDTH; ++l) {
+			r[l] = pointr[b * WIDTH + l].GetRawVal();
+			i[l] = pointi[b * WIDTH + l].GetRawVal();
+			interior[l] = checkInterior && is_main_cardioid_or_bulb<T>(pointr[b * WIDTH + l], pointi[b * WIDTH + l]) ? -1 : 0;
+		}
+		cr[b] = _mm256_loadu_si256((const __m256i*) r);
+		ci[b] = _mm256_loadu_si256((const __m256i*) i);
+		zr[b] = zi[b] = zrsqr[b] = zisqr[b] = _mm256_setzero_si256();
+		savedr[b] = savedi[b] = _mm256_setzero_si256();
+		work[b] = _mm256_setzero_si256();
+		const __m256i in = _mm256_loadu_si256((const __m256i*) interior);
+		count[b] = _mm256_and_si256(in, maxIt);
+		active[b] = _mm256_andnot_si256(in, _mm256_set1_epi32(-1));
+	}
+
+	fd_iter_count_t steps = 0;
+	fd_iter_count_t checkpoint = 1;
+	for (; steps < currentIt; ++steps) {
+		__m256i any = active[0];
+		for (size_t b = 1; b < BLOCKS; ++b)
+			any = _mm256_or_si256(any, active[b]);
+		//only the lower 4 bytes of every element are meaningful
+		if ((_mm256_movemask_epi8(any) & 0x0F0F0F0F) == 0)
+			break;
+
+		const bool periodicity = checkInterior && ((steps + 1) % FD_PERIODICITY_CHECK) == 0;
+		for (size_t b = 0; b < BLOCKS; ++b) {
+			zi[b] = _mm256_srli_epi64(_mm256_mul_epi32(_mm256_add_epi32(zr[b], zr[b]), zi[b]), FRAC_BITS);
+			zi[b] = _mm256_add_epi32(zi[b], ci[b]);
+			zr[b] = _mm256_add_epi32(_mm256_sub_epi32(zrsqr[b], zisqr[b]), cr[b]);
+
+			zrsqr[b] = _mm256_srli_epi64(_mm256_mul_epi32(zr[b], zr[b]), FRAC_BITS);
+			zisqr[b] = _mm256_srli_epi64(_mm256_mul_epi32(zi[b], zi[b]), FRAC_BITS);
+
+			const __m256i iterated = active[b];
+			count[b] = _mm256_sub_epi32(count[b], iterated);
+			work[b] = _mm256_sub_epi32(work[b], iterated);
+			active[b] = _mm256_andnot_si256(_mm256_cmpgt_epi32(_mm256_add_epi32(zrsqr[b], zisqr[b]), four), active[b]);
+
+			//like the scalar kernel this also catches lanes in the iteration they escape
+			if (periodicity) {
+				const __m256i dr = _mm256_sub_epi32(zr[b], savedr[b]);
+				const __m256i di = _mm256_sub_epi32(zi[b], savedi[b]);
+				const __m256i far = _mm256_or_si256(_mm256_or_si256(_mm256_cmpgt_epi32(dr, epsilon), _mm256_cmpgt_epi32(minusEpsilon, dr)),
+						_mm256_or_si256(_mm256_cmpgt_epi32(di, epsilon), _mm256_cmpgt_epi32(minusEpsilon, di)));
+				const __m256i periodic = _mm256_andnot_si256(far, iterated);
+				count[b] = _mm256_or_si256(_mm256_andnot_si256(periodic, count[b]), _mm256_and_si256(periodic, maxIt));
+				active[b] = _mm256_andnot_si256(periodic, active[b]);
+			}
+		}
+
+		if (checkInterior && steps + 1 == checkpoint) {
+			for (size_t b = 0; b < BLOCKS; ++b) {
+				savedr[b] = zr[b];
+				savedi[b] = zi[b];
+			}
+			checkpoint <<= 1;
+		}
+	}
+
+	for (size_t b = 0; b < BLOCKS; ++b) {
+		int64_t c[WIDTH], w[WIDTH];
+		_mm256_storeu_si256((__m256i*) c, count[b]);
+		_mm256_storeu_si256((__m256i*) w, work[b]);
+		for (size_t l = 0; l < WIDTH; ++l) {
+			iterations[b * WIDTH + l] = uint32_t(c[l]);
+			stats.iterations_ += uint32_t(w[l]);
+		}
+	}
+	stats.slots_ += uint64_t(steps) * Lanes;
+}
+
+//iterates a span of points in batches of "Lanes". the tail is padded with the last point.
+template<typename T, size_t Lanes>
+__attribute__((target("avx2"))) void mandelbrot_fixed_simd(const T* pointr, const T* pointi, fd_iter_count_t* iterations, const size_t& size, const fd_iter_count_t& currentIt, const bool& checkInterior, const FormulaParams& params, LaneStats& stats) {
+	size_t i = 0;
+	for (; i + Lanes <= size; i += Lanes) {
+		mandelbrot_fixed_lanes<T, Lanes>(pointr + i, pointi + i, iterations + i, currentIt, checkInterior, stats);
+	}
+
+	if (i < size) {
+		T tailr[Lanes];
+		T taili[Lanes];
+		fd_iter_count_t tailIterations[Lanes];
+		for (size_t j = 0; j < Lanes; ++j) {
+			size_t k = std::min(i + j, size - 1);
+			tailr[j] = pointr[k];
+			taili[j] = pointi[k];
+		}
+		mandelbrot_fixed_lanes<T, Lanes>(tailr, taili, tailIterations, currentIt, checkInterior, stats);
+		memcpy(iterations + i, tailIterations, (size - i) * sizeof(fd_iter_count_t));
+	}
+}
+
+//the persistent lanes variant (see mandelbrot_persistent) of mandelbrot_fixed_lanes. every lane keeps its own
+//iteration count, which also decides when its orbit is compared with the saved one and when it is saved.
+template<typename T, size_t Lanes>
+__attribute__((target("avx2"))) void mandelbrot_fixed_persistent(const T* pointr, const T* pointi, const size_t& width, const size_t& rows, fd_iter_count_t* iterations, const fd_iter_count_t& currentIt, const bool& checkInterior, const FormulaParams& params, LaneStats& stats) {
+	typedef FixedPointTraits<T> traits;
+	static_assert(std::is_same<typename traits::raw_t, int32_t>::value, "the fixed point simd kernel needs 32-bit raw values");
+	constexpr size_t WIDTH = 4;
+	constexpr size_t BLOCKS = Lanes / WIDTH;
+	constexpr int FRAC_BITS = traits::FRAC_BITS;
+
+	__m256i cr[BLOCKS], ci[BLOCKS];
+	__m256i zr[BLOCKS], zi[BLOCKS];
+	__m256i zrsqr[BLOCKS], zisqr[BLOCKS];
+	__m256i savedr[BLOCKS], savedi[BLOCKS];
+	__m256i count[BLOCKS], active[BLOCKS], work[BLOCKS];
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i one = _mm256_set1_epi32(1);
+	const __m256i periodMask = _mm256_set1_epi32(FD_PERIODICITY_CHECK - 1);
+	const __m256i four = _mm256_set1_epi32(T(4.0).GetRawVal());
+	const __m256i epsilon = _mm256_set1_epi32(Periodicity<T>::epsilon().GetRawVal());
+	const __m256i minusEpsilon = _mm256_set1_epi32(-Periodicity<T>::epsilon().GetRawVal());
+	const __m256i maxIt = _mm256_set1_epi32(currentIt);
+	//the pixel of every lane, SIZE_MAX if the lane is empty
+	size_t pixel[Lanes];
+	const size_t size = width * rows;
+	size_t next = 0;
+	uint64_t steps = 0;
+
+	for (size_t b = 0; b < BLOCKS; ++b) {
+		cr[b] = ci[b] = zr[b] = zi[b] = zrsqr[b] = zisqr[b] = savedr[b] = savedi[b] = zero;
+		count[b] = active[b] = work[b] = zero;
+	}
+	std::fill(pixel, pixel + Lanes, SIZE_MAX);
+
+	for (;;) {
+		//write the lanes that escaped, reached currentIt or ran into a cycle and refill them
+		bool occupied = false;
+		for (size_t b = 0; b < BLOCKS; ++b) {
+			int64_t r[WIDTH], i[WIDTH], c[WIDTH], a[WIDTH], w[WIDTH], fresh[WIDTH];
+			_mm256_storeu_si256((__m256i*) c, count[b]);
+			_mm256_storeu_si256((__m256i*) a, active[b]);
+			_mm256_storeu_si256((__m256i*) w, work[b]);
+			bool refilled = false;
+			for (size_t l = 0; l < WIDTH; ++l) {
+				size_t& p = pixel[b * WIDTH + l];
+				fresh[l] = 0;
+				if (p != SIZE_MAX) {
+					if (int32_t(a[l]) != 0) {
+						occupied = true;
+						continue;
+					}
+					iterations[p] = uint32_t(c[l]);
+					stats.iterations_ += uint32_t(w[l]);
+				}
+
+				if (checkInterior) {
+					while (next < size && is_main_cardioid_or_bulb<T>(pointr[next % width], pointi[next / width])) {
+						iterations[next] = currentIt;
+						++next;
+					}
+				}
+
+				refilled = true;
+				fresh[l] = -1;
+				if (next < size) {
+					p = next++;
+					r[l] = pointr[p % width].GetRawVal();
+					i[l] = pointi[p / width].GetRawVal();
+					a[l] = currentIt > 0 ? -1 : 0;
+					occupied = true;
+				} else {
+					p = SIZE_MAX;
+					r[l] = i[l] = a[l] = 0;
+				}
+				c[l] = w[l] = 0;
+			}
+			if (!refilled)
+				continue;
+
+			//the lanes that weren't refilled keep their state
+			const __m256i f = _mm256_loadu_si256((const __m256i*) fresh);
+			cr[b] = _mm256_blendv_epi8(cr[b], _mm256_loadu_si256((const __m256i*) r), f);
+			ci[b] = _mm256_blendv_epi8(ci[b], _mm256_loadu_si256((const __m256i*) i), f);
+			zr[b] = _mm256_andnot_si256(f, zr[b]);
+			zi[b] = _mm256_andnot_si256(f, zi[b]);
+			zrsqr[b] = _mm256_andnot_si256(f, zrsqr[b]);
+			zisqr[b] = _mm256_andnot_si256(f, zisqr[b]);
+			savedr[b] = _mm256_andnot_si256(f, savedr[b]);
+			savedi[b] = _mm256_andnot_si256(f, savedi[b]);
+			count[b] = _mm256_loadu_si256((const __m256i*) c);
+			work[b] = _mm256_loadu_si256((const __m256i*) w);
+			active[b] = _mm256_loadu_si256((const __m256i*) a);
+		}
+
+		if (!occupied)
+			break;
+
+		//iterate until a lane is done. that is only checked every FD_PERSISTENT_CHECK steps because a refill costs a
+		//scalar pass over all lanes.
+		bool done = false;
+		do {
+			for (size_t i = 0; i < FD_PERSISTENT_CHECK; ++i) {
+				for (size_t b = 0; b < BLOCKS; ++b) {
+					zi[b] = _mm256_srli_epi64(_mm256_mul_epi32(_mm256_add_epi32(zr[b], zr[b]), zi[b]), FRAC_BITS);
+					zi[b] = _mm256_add_epi32(zi[b], ci[b]);
+					zr[b] = _mm256_add_epi32(_mm256_sub_epi32(zrsqr[b], zisqr[b]), cr[b]);
+
+					zrsqr[b] = _mm256_srli_epi64(_mm256_mul_epi32(zr[b], zr[b]), FRAC_BITS);
+					zisqr[b] = _mm256_srli_epi64(_mm256_mul_epi32(zi[b], zi[b]), FRAC_BITS);
+
+					//the zero-extended iteration counts stay below currentIt, so the signed comparison is safe
+					const __m256i iterated = active[b];
+					count[b] = _mm256_sub_epi32(count[b], iterated);
+					work[b] = _mm256_sub_epi32(work[b], iterated);
+					active[b] = _mm256_andnot_si256(_mm256_cmpgt_epi32(_mm256_add_epi32(zrsqr[b], zisqr[b]), four), active[b]);
+
+					if (checkInterior) {
+						const __m256i dr = _mm256_sub_epi32(zr[b], savedr[b]);
+						const __m256i di = _mm256_sub_epi32(zi[b], savedi[b]);
+						const __m256i far = _mm256_or_si256(_mm256_or_si256(_mm256_cmpgt_epi32(dr, epsilon), _mm256_cmpgt_epi32(minusEpsilon, dr)),
+								_mm256_or_si256(_mm256_cmpgt_epi32(di, epsilon), _mm256_cmpgt_epi32(minusEpsilon, di)));
+						const __m256i check = _mm256_and_si256(iterated, _mm256_cmpeq_epi32(_mm256_and_si256(count[b], periodMask), zero));
+						const __m256i periodic = _mm256_andnot_si256(far, check);
+						count[b] = _mm256_blendv_epi8(count[b], maxIt, periodic);
+						active[b] = _mm256_andnot_si256(periodic, active[b]);
+
+						//saved at every power of two
+						const __m256i save = _mm256_and_si256(iterated, _mm256_cmpeq_epi32(_mm256_and_si256(count[b], _mm256_sub_epi32(count[b], one)), zero));
+						savedr[b] = _mm256_blendv_epi8(savedr[b], zr[b], save);
+						savedi[b] = _mm256_blendv_epi8(savedi[b], zi[b], save);
+					}
+					active[b] = _mm256_and_si256(active[b], _mm256_cmpgt_epi32(maxIt, count[b]));
+				}
+			}
+			steps += FD_PERSISTENT_CHECK;
+
+			for (size_t b = 0; b < BLOCKS && !done; ++b) {
+				//occupied lanes that aren't active any more have their lower 4 bytes cleared
+				int64_t a[WIDTH];
+				_mm256_storeu_si256((__m256i*) a, active[b]);
+				for (size_t l = 0; l < WIDTH; ++l)
+					done |= pixel[b * WIDTH + l] != SIZE_MAX && int32_t(a[l]) == 0;
+			}
+		} while (!done);
+	}
+
+	stats.slots_ += steps * Lanes;
+}
+#endif
+
+} /* namespace fractaldive */
+
+#endif /* SRC_KERNEL_HPP_ */
@@ -1,4 +1,6 @@
 #include <map>
+#include <deque>
+#include <limits>
 #ifndef _JAVASCRIPT
 #include <csignal>
 #else
@@ -28,7 +30,9 @@ struct ZoomEvent {
 };
 
 ZoomEvent current_zoom_event;
-void process_events() {
+//returns true if a mouse button went down, which takes the camera over from the autopilot
+bool process_events() {
+	bool takeover = false;
 	SDL_Event test_event;
 	while (SDL_PollEvent(&test_event)) {
 		switch (test_event.type) {
@@ -38,6 +42,7 @@ void process_events() {
 		case SDL_MOUSEBUTTONDOWN:
 			current_zoom_event.zoomPoint_ = {test_event.motion.x, test_event.motion.y};
 			current_zoom_event.active_ = true;
+			takeover = true;
 			break;
 		case SDL_MOUSEMOTION:
 			if(current_zoom_event.active_)
@@ -52,10 +57,73 @@ void process_events() {
 			break;
 		}
 	}
+	return takeover;
+}
+
+//steers directly towards the boundary of the set: picks the tile with the most pixels less than a pixel away from the
+//boundary and in it the boundary pixel closest to the center of the tile. if there is no such pixel, the exterior
+//pixel closest to the boundary. unlike the color changes measureImageDetail counts that doesn't depend on the
+//iteration depth.
+std::pair<fd_coord_t, fd_coord_t> identifyBoundaryOfTile(const fd_float_t* distances, const fd_dim_t& tiling) {
+	const fd_coord_t width = CONFIG.width_;
+	const fd_coord_t tileW = std::floor(fd_float_t(CONFIG.width_) / fd_float_t(tiling));
+	const fd_coord_t tileH = std::floor(fd_float_t(CONFIG.height_) / fd_float_t(tiling));
+	size_t candidateCount = 0;
+	fd_coord_t candidateTx = 0;
+	fd_coord_t candidateTy = 0;
+	fd_float_t closest = std::numeric_limits<fd_float_t>::max();
+	std::pair<fd_coord_t, fd_coord_t> closestPixel = { width / 2, CONFIG.height_ / 2 };
+
+	for (fd_dim_t ty = 0; ty < tiling; ++ty) {
+		for (fd_dim_t tx = 0; tx < tiling; ++tx) {
+			size_t count = 0;
+			for (fd_coord_t y = ty * tileH; y < fd_coord_t(ty + 1) * tileH; ++y) {
+				for (fd_coord_t x = tx * tileW; x < fd_coord_t(tx + 1) * tileW; ++x) {
+					const fd_float_t d = distances[y * width + x];
+					if (d <= 0)
+						continue;
+					if (d < 1)
+						++count;
+					if (d < closest) {
+						closest = d;
+						closestPixel = { x, y };
+					}
+				}
+			}
+			if (count > candidateCount) {
+				candidateCount = count;
+				candidateTx = tx;
+				candidateTy = ty;
+			}
+		}
+	}
+
+	if (candidateCount == 0)
+		return closestPixel;
+
+	const fd_coord_t centerX = (candidateTx * tileW) + (tileW / 2);
+	const fd_coord_t centerY = (candidateTy * tileH) + (tileH / 2);
+	fd_coord_t nearest = std::numeric_limits<fd_coord_t>::max();
+	std::pair<fd_coord_t, fd_coord_t> target = { centerX, centerY };
+	for (fd_coord_t y = candidateTy * tileH; y < (candidateTy + 1) * tileH; ++y) {
+		for (fd_coord_t x = candidateTx * tileW; x < (candidateTx + 1) * tileW; ++x) {
+			const fd_float_t d = distances[y * width + x];
+			const fd_coord_t dist = (x - centerX) * (x - centerX) + (y - centerY) * (y - centerY);
+			if (d > 0 && d < 1 && dist < nearest) {
+				nearest = dist;
+				target = { x, y };
+			}
+		}
+	}
+	return target;
 }
 
 std::pair<fd_coord_t, fd_coord_t> identifyCenterOfTileOfDetail(const fd_dim_t& tiling) {
 	assert(tiling > 1);
+	const fd_float_t* distances = RENDERER.getDistances();
+	if (distances != nullptr)
+		return identifyBoundaryOfTile(distances, tiling);
+
 	const fd_coord_t tileW = std::floor(fd_float_t(CONFIG.width_) / fd_float_t(tiling));
 	const fd_coord_t tileH = std::floor(fd_float_t(CONFIG.height_) / fd_float_t(tiling));
 	assert(tileW > 1);
@@ -63,8 +131,8 @@ std::pair<fd_coord_t, fd_coord_t> identifyCenterOfTileOfDetail(const fd_dim_t& t
 
 	const size_t tileSize = tileW * tileH;
 
-	const auto& image = RENDERER.imageData_;
-	std::vector<fd_image_pix_t> tile(tileSize);
+	const IterationBuffer& iterations = RENDERER.getIterations();
+	std::vector<fd_iter_count_t> tile(tileSize);
 	std::map<fd_float_t,std::pair<fd_float_t, fd_float_t>> candidates;
 
 
@@ -78,7 +146,7 @@ std::pair<fd_coord_t, fd_coord_t> identifyCenterOfTileOfDetail(const fd_dim_t& t
 			for (fd_coord_t y = 0; y < tileH; ++y) {
 				for (fd_coord_t x = 0; x < tileW; ++x) {
 					const size_t pixIdx = (offY + (y * CONFIG.width_)) + (offX + x);
-					tile[y * tileW + x] = image[pixIdx];
+					tile[y * tileW + x] = iterations[pixIdx];
 				}
 			}
 			fd_float_t score = measureImageDetail(tile.data(), tileW * tileH);
@@ -104,14 +172,48 @@ std::pair<fd_coord_t, fd_coord_t> identifyCenterOfTileOfDetail(const fd_dim_t& t
 	return { (candidateTx * tileW) + (tileW / 2), (candidateTy * tileH) + (tileH / 2) };
 }
 
-bool dive(bool zoom, bool benchmark) {
-	fd_float_t detail = measureImageDetail(RENDERER.imageData_, CONFIG.frameSize_);
+//busy/idle time of every thread during the last frame
+void printThreadStats() {
+	const Renderer::ThreadStats stats = RENDERER.getThreadStats();
+	if (stats.busy_.empty())
+		return;
+
+	std::string line;
+	for (size_t i = 0; i < stats.busy_.size(); ++i) {
+		char buffer[32];
+		snprintf(buffer, sizeof(buffer), " %.1f/%.1f", stats.busy_[i] / 1000.0, stats.idle_[i] / 1000.0);
+		line += buffer;
+	}
+	print("Threads busy/idle ms:" + line);
+}
+
+//follows changes of the cpus the process can keep busy between frames, e.g. of the cpu quota of its container. the
+//quota is checked about once a second. a pool of one thread per physical core keeps its size.
+void fit_thread_pool() {
+	static fd_highres_tick_t lastCheck = 0;
+	const fd_highres_tick_t now = get_milliseconds();
+	if (CONFIG.pin_ == PIN_PHYSICAL || now - lastCheck < 1000)
+		return;
+	lastCheck = now;
+	const size_t cores = ThreadPool::cores();
+	if (cores > 0 && cores != ThreadPool::size()) {
+		print("Threads:", ThreadPool::size(), "->", cores);
+		ThreadPool::getInstance().resize(cores);
+	}
+}
+
+//moves the camera for the next frame: towards the mouse while a button is down, otherwise by the autopilot, which
+//looks at the last frame rendered. returns false once that frame has too little detail left.
+bool advance(bool zoom, bool benchmark) {
+	const IterationBuffer& iterations = RENDERER.getIterations();
+	fd_float_t detail = iterations.isCompact() ? measureImageDetail(iterations.compact(), CONFIG.frameSize_) : measureImageDetail(iterations.wide(), CONFIG.frameSize_);
 
 	if (!benchmark && detail < CONFIG.detailThreshold_) {
 		return false;
 	}
+	if (zoom && !CAMERA.canZoomIn())
+		return false;
 	if (zoom) {
-		process_events();
 		std::pair<fd_coord_t, fd_coord_t> centerOfHighDetail;
 		if(current_zoom_event.zoomPoint_.first == 0 && current_zoom_event.zoomPoint_.second == 0) {
 			centerOfHighDetail = identifyCenterOfTileOfDetail(CONFIG.frameTiling_);
@@ -132,15 +234,138 @@ bool dive(bool zoom, bool benchmark) {
 			}
 		}
 	}
+	return true;
+}
 
-#ifndef _NO_THREADS
-	if(ThreadPool::getInstance().taskCount() > 0) {
-		ThreadPool::getInstance().join();
+bool dive(bool zoom, bool benchmark) {
+	if (zoom)
+		process_events();
+	//the last frame may still be rendering. advance() reads its iterations, so wait for it to complete. the pool is
+	//idle then and can be resized.
+	ThreadPool::getInstance().join();
+	if (!advance(zoom, benchmark))
+		return false;
+
+	fit_thread_pool();
+	if (CONFIG.threadStats_)
+		printThreadStats();
+
+	//the next frame is rendered into another buffer while the last one is drawn
+	RENDERER.render();
+	const fd_image_pix_t* frame = RENDERER.acquireFrame();
+	CANVAS.draw(frame);
+	RENDERER.releaseFrame(frame);
+	return true;
+}
+
+//render-ahead (see Config::renderAhead_): the autopilot only looks at frames that are already rendered, so they can
+//be rendered ahead of displaying them. a frame that takes longer than its time slot is absorbed by the frames rendered
+//in the slots before. every frame is queued with a snapshot of the camera it is rendered with. the last one may still
+//be rendering, its image_ is nullptr until it is complete.
+struct AheadFrame {
+	const fd_image_pix_t* image_;
+	Camera camera_;
+};
+
+std::deque<AheadFrame> AHEAD;
+//the camera of the frame on screen
+Camera SHOWN_CAMERA(CAMERA);
+//the autopilot ran out of detail. the dive ends once the queue is drained.
+bool AHEAD_DONE = false;
+//without threads render() returns once the frame is complete. how long the last one took.
+fd_highres_tick_t INLINE_RENDER_MILLIS = 0;
+
+//picks up the frame in flight once it is complete and starts the next one if the queue has room. while a mouse button
+//is down only one frame is rendered ahead, so the camera follows the mouse without delay. without threads a frame is
+//only rendered ahead if it is likely to be done within millisLeft, so it doesn't delay the frame that is due next.
+void render_ahead(const int32_t& millisLeft) {
+	if (!AHEAD.empty() && AHEAD.back().image_ == nullptr) {
+		if (!RENDERER.isFrameDone())
+			return;
+		AHEAD.back().image_ = RENDERER.acquireFrame();
 	}
-#endif
+	const size_t depth = current_zoom_event.active_ ? 1 : CONFIG.renderAhead_;
+	if (AHEAD_DONE || AHEAD.size() >= depth)
+		return;
+	const bool threaded = ThreadPool::size() > 1;
+	if (!threaded && !AHEAD.empty() && int32_t(INLINE_RENDER_MILLIS) > millisLeft)
+		return;
+	if (!advance(true, false)) {
+		AHEAD_DONE = true;
+		return;
+	}
+
+	ThreadPool::getInstance().join();
+	fit_thread_pool();
+	if (CONFIG.threadStats_)
+		printThreadStats();
+	AHEAD.push_back({ nullptr, CAMERA });
+	const fd_highres_tick_t start = get_milliseconds();
+	RENDERER.render();
+	if (!threaded)
+		INLINE_RENDER_MILLIS = get_milliseconds() - start;
+}
+
+//mouse input takes the camera over: the frames rendered ahead are dropped and the camera continues from the frame on
+//screen
+void flush_ahead() {
+	ThreadPool::getInstance().join();
+	for (const AheadFrame& frame : AHEAD) {
+		if (frame.image_ != nullptr)
+			RENDERER.releaseFrame(frame.image_);
+	}
+	AHEAD.clear();
+	AHEAD_DONE = false;
+	CAMERA.restore(SHOWN_CAMERA);
+}
 
-	CANVAS.draw(RENDERER.imageData_);
+//renders the first frame of a dive
+void start_dive() {
 	RENDERER.render();
+	if (CONFIG.renderAhead_ > 0) {
+		AHEAD_DONE = false;
+		SHOWN_CAMERA.restore(CAMERA);
+		AHEAD.push_back({ nullptr, CAMERA });
+	}
+}
+
+//shows the next frame of the queue and renders ahead until the one after it is due
+bool step_ahead() {
+	const fd_highres_tick_t start = get_milliseconds();
+	const int32_t targetMillis = 1000.0 / CONFIG.fps_;
+	if (process_events())
+		flush_ahead();
+	//shows the frame that is due before rendering more
+	render_ahead(0);
+	if (AHEAD.empty())
+		return false;
+
+	if (AHEAD.front().image_ == nullptr) {
+		//the frame is due but still rendering
+		ThreadPool::getInstance().join();
+		render_ahead(0);
+	}
+	const AheadFrame& frame = AHEAD.front();
+	CANVAS.draw(frame.image_);
+	RENDERER.releaseFrame(frame.image_);
+	SHOWN_CAMERA.restore(frame.camera_);
+	AHEAD.pop_front();
+
+	//renders ahead until the next frame is due. waits for the frame in flight or sleeps when there is nothing to do.
+	while (DO_RUN) {
+		render_ahead(targetMillis - int32_t(get_milliseconds() - start));
+		const int32_t diff = targetMillis - int32_t(get_milliseconds() - start);
+		if (diff < 0) {
+			printErr("Underrun: ", std::abs(diff));
+			break;
+		}
+		if (AHEAD.empty() || AHEAD.back().image_ != nullptr) {
+			sleep_millis(diff);
+			break;
+		}
+		if (!RENDERER.waitForFrame(diff))
+			break;
+	}
 	return true;
 }
 
@@ -149,10 +374,15 @@ bool auto_scale_max_iterations() {
 	auto duration = start;
 
 	size_t cnt = 0;
+	//measure full frames. reprojection would just copy the unchanged frame
+	RENDERER.setReprojection(false);
+	RENDERER.setSymmetry(false);
 	while ((duration = (get_milliseconds() - start)) < CONFIG.benchmarkTimeoutMillis_) {
 		dive(false, true);
 		++cnt;
 	}
+	RENDERER.setReprojection(true);
+	RENDERER.setSymmetry(true);
 
 	CAMERA.reset();
 	fd_float_t fpsMillis = 1000.0 / CONFIG.fps_;
@@ -160,6 +390,14 @@ bool auto_scale_max_iterations() {
 	fd_iter_count_t iterations = round((CONFIG.startIterations_ / millisRatio)) / 10.0;
 
 	print(iterations);
+	print("Throughput:", (fd_float_t(cnt) * CONFIG.frameSize_) / (duration * 1000.0), "Mpix/s");
+	if (CONFIG.kernel_ != KERNEL_SCALAR && !RENDERER.isPerturbating())
+		print("Lane utilization:", RENDERER.getLaneUtilization() * 100.0, "%");
+	if (CONFIG.renderMode_ != RENDER_FULL)
+		print("Filled:", RENDERER.getFillRatio() * 100.0, "%");
+	if (ThreadPool::size() > 1)
+		print("Threads busy:", RENDERER.getBusyRatio() * 100.0, "%");
+	RENDERER.resetStats();
 #ifdef _BENCHMARK_ONLY
 	return true;
 #endif
@@ -171,6 +409,9 @@ bool auto_scale_max_iterations() {
 }
 
 bool step() {
+	if (CONFIG.renderAhead_ > 0)
+		return step_ahead();
+
 	auto start = get_milliseconds();
 	bool result = dive(true, false);
 	auto duration = get_milliseconds() - start;
@@ -198,23 +439,76 @@ void printReport() {
 
 	print("");
 	print("# FEATURES");
-	print(pad_string("Threads:", padWidth), ThreadPool::cores());
+	print(pad_string("Threads:", padWidth), ThreadPool::size());
+	if (CONFIG.waitPolicy_ == WAIT_SPIN)
+		print(pad_string("Thread wait:", padWidth), "spin for", CONFIG.spinMicros_, "us, then park");
+	else
+		print(pad_string("Thread wait:", padWidth), "park");
+	print(pad_string("Pinning:", padWidth), pin_policy_name(CONFIG.pin_));
 #ifdef _AUTOVECTOR
 	print(pad_string("Auto Vector/SIMD:", padWidth),"on");
 #else
 	print(pad_string("Auto Vector/SIMD:", padWidth), "off");
 #endif
 
+	print(pad_string("SIMD:", padWidth), simd_level_name(CONFIG.simdLevel_), "(cpu supports", std::string(simd_level_name(detect_simd_level())) + ")");
+	if (CONFIG.kernel_ == KERNEL_SIMD)
+		print(pad_string("Kernel:", padWidth), "simd x" + std::to_string(CONFIG.simdLanes_));
+	else if (CONFIG.kernel_ == KERNEL_SIMD_PERSISTENT)
+		print(pad_string("Kernel:", padWidth), "simd persistent x" + std::to_string(CONFIG.simdLanes_));
+	else if (CONFIG.unroll_ > 1)
+		print(pad_string("Kernel:", padWidth), "scalar unrolled x" + std::to_string(CONFIG.unroll_));
+	else
+		print(pad_string("Kernel:", padWidth), "scalar");
+	if (CONFIG.renderMode_ == RENDER_RECTANGLES)
+		print(pad_string("Render mode:", padWidth), "rectangles");
+	else if (CONFIG.renderMode_ == RENDER_GUESSING)
+		print(pad_string("Render mode:", padWidth), "guessing x" + std::to_string(CONFIG.guessingStep_));
+	else
+		print(pad_string("Render mode:", padWidth), "full");
+	if (CONFIG.schedule_ == SCHEDULE_STEALING)
+		print(pad_string("Schedule:", padWidth), "work stealing, tiles of", CONFIG.scheduleTile_, "rows");
+	else if (CONFIG.schedule_ == SCHEDULE_COST)
+		print(pad_string("Schedule:", padWidth), "cost model, tiles of", CONFIG.scheduleTile_, "rows");
+	else
+		print(pad_string("Schedule:", padWidth), "stripes");
+	print(pad_string("Interior check:", padWidth), CONFIG.interiorCheck_ ? "on" : "off");
+	if (CONFIG.formula_ == FORMULA_JULIA)
+		print(pad_string("Formula:", padWidth), formula_name(CONFIG.formula_), CONFIG.formulaParams_.juliar_, CONFIG.formulaParams_.juliai_);
+	else
+		print(pad_string("Formula:", padWidth), formula_name(CONFIG.formula_));
+	if (CONFIG.perturbationZoom_ > 0 && CONFIG.formula_ == FORMULA_MANDELBROT)
+		print(pad_string("Perturbation:", padWidth), "from zoom", CONFIG.perturbationZoom_, "with", CONFIG.perturbationReferences_, "references");
+	else
+		print(pad_string("Perturbation:", padWidth), "off");
+	if (CONFIG.reprojection_)
+		print(pad_string("Reprojection:", padWidth), "tolerance", CONFIG.reprojectionTolerance_, "refresh", CONFIG.reprojectionRefresh_);
+	else
+		print(pad_string("Reprojection:", padWidth), "off");
+	print(pad_string("Symmetry:", padWidth), CONFIG.symmetry_ ? "on" : "off");
+	if (CONFIG.distanceEstimation_ && has_distance_estimate(CONFIG.formula_))
+		print(pad_string("Distance field:", padWidth), "on");
+	else
+		print(pad_string("Distance field:", padWidth), "off");
+
 #ifdef _FIXEDPOINT
 	print(pad_string("Arithmetic:", padWidth),"fixed point");
 #else
 	print(pad_string("Arithmetic:", padWidth), "floating point");
 #endif
+#ifdef _FIXEDPOINT
 	print(pad_string("Precision:", padWidth), FD_PRECISION);
+#else
+	if (CONFIG.autoPrecision_)
+		print(pad_string("Precision:", padWidth), "auto with", CONFIG.precisionGuardBits_, "guard bits");
+	else
+		print(pad_string("Precision:", padWidth), precision_name(CONFIG.precision_));
+#endif
 	print("");
 
 	print("# SCALING");
 	print(pad_string("FPS:", padWidth), CONFIG.fps_);
+	print(pad_string("Render ahead:", padWidth), CONFIG.renderAhead_, "frames");
 	print(pad_string("Max iterations:", padWidth), RENDERER.getMaxIterations(), "of", CONFIG.maxIterations_);
 	print(pad_string("Detail threshold:", padWidth), CONFIG.detailThreshold_);
 	print(pad_string("Pan history:", padWidth), CONFIG.panSmoothLen_);
@@ -241,7 +535,7 @@ void run() {
 		CAMERA.reset();
 		CAMERA.initSmoothPan(0,0, CONFIG.panSmoothLen_);
 		RENDERER.makeNewPalette();
-		RENDERER.render();
+		start_dive();
 
 		bool stepResult = true;
 		while (DO_RUN && stepResult) {
@@ -274,6 +568,13 @@ int main() {
 	assert(CONFIG.startIterations_ > 3);
 	assert(CONFIG.fps_ > 0);
 
+	//physical: one thread per core. the pool is sized before it is created.
+	const std::vector<int> cpus = pin_order(read_topology(), CONFIG.pin_);
+	if (CONFIG.pin_ == PIN_PHYSICAL && !cpus.empty())
+		ThreadPool::setSize(cpus.size());
+	if (CONFIG.pin_ != PIN_NONE && !ThreadPool::getInstance().pin(cpus))
+		CONFIG.pin_ = PIN_NONE;
+	ThreadPool::getInstance().setWaitPolicy(CONFIG.waitPolicy_, CONFIG.spinMicros_);
 	srand(time(NULL));
 #ifndef _JAVASCRIPT
 #ifndef _AMIGA
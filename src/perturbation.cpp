@@ -0,0 +1,164 @@
+#include "perturbation.hpp"
+
+#include <cassert>
+#include <atomic>
+
+namespace fractaldive {
+
+#ifndef _FIXEDPOINT
+ReferenceOrbit::ReferenceOrbit(const fd_dim_t& x, const fd_dim_t& y, const fd_bigfloat_t& cr, const fd_bigfloat_t& ci, const fd_iter_count_t& maxIterations) :
+		x_(x), y_(y) {
+	zr_.reserve(maxIterations + 1);
+	zi_.reserve(maxIterations + 1);
+	glitch_.reserve(maxIterations + 1);
+
+	fd_bigfloat_t zr = 0, zi = 0;
+	fd_bigfloat_t zrsqr = 0;
+	fd_bigfloat_t zisqr = 0;
+	zr_.push_back(0);
+	zi_.push_back(0);
+	glitch_.push_back(0);
+
+	for (fd_iter_count_t i = 0; i < maxIterations; ++i) {
+		zi = (zr + zr) * zi;
+		zi += ci;
+		zr = (zrsqr - zisqr) + cr;
+
+		zrsqr = zr * zr;
+		zisqr = zi * zi;
+
+		const fd_mandelfloat_t r = zr;
+		const fd_mandelfloat_t im = zi;
+		zr_.push_back(r);
+		zi_.push_back(im);
+		//|z| / |Z| < 1e-3 (Pauldelbrot's criterion)
+		glitch_.push_back((r * r + im * im) * 1e-6);
+
+		if (zrsqr + zisqr > 4)
+			break;
+	}
+}
+
+void Perturbation::prepare(const fd_bigfloat_t& originr, const fd_bigfloat_t& origini, const fd_bigfloat_t& stepr, const fd_bigfloat_t& stepi, const fd_iter_count_t& maxIterations) {
+	std::shared_ptr<const Frame> frame = std::make_shared<const Frame>(originr, origini, stepr, stepi, maxIterations, longestReference(originr, origini, stepr, stepi, maxIterations));
+	std::atomic_store(&frame_, frame);
+}
+
+//the reference orbit at the center of the frame. if that escapes before maxIterations, the pixels that live longer
+//than the reference all glitch, so a grid of candidates is tried and the one that survives longest is taken.
+ReferenceOrbit Perturbation::longestReference(const fd_bigfloat_t& originr, const fd_bigfloat_t& origini, const fd_bigfloat_t& stepr, const fd_bigfloat_t& stepi, const fd_iter_count_t& maxIterations) const {
+	const size_t grid = 4;
+	ReferenceOrbit longest(width_ / 2, height_ / 2, originr + stepr * (width_ / 2), origini + stepi * (height_ / 2), maxIterations);
+
+	for (size_t i = 0; i < grid * grid && longest.size() <= maxIterations; ++i) {
+		const fd_dim_t x = (2 * (i % grid) + 1) * width_ / (2 * grid);
+		const fd_dim_t y = (2 * (i / grid) + 1) * height_ / (2 * grid);
+		ReferenceOrbit candidate(x, y, originr + stepr * x, origini + stepi * y, maxIterations);
+		if (candidate.size() > longest.size())
+			longest = std::move(candidate);
+	}
+	return longest;
+}
+
+inline fd_iter_count_t Perturbation::iterate(const ReferenceOrbit& reference, const fd_iter_count_t& maxIterations, const fd_mandelfloat_t& dcr, const fd_mandelfloat_t& dci, bool& glitched) const {
+	const size_t size = reference.size();
+	const fd_mandelfloat_t* Zr = reference.zr_.data();
+	const fd_mandelfloat_t* Zi = reference.zi_.data();
+	const fd_mandelfloat_t* glitch = reference.glitch_.data();
+	fd_mandelfloat_t dzr = 0, dzi = 0;
+	fd_mandelfloat_t zr = 0, zi = 0;
+	fd_mandelfloat_t four = 4.0;
+	fd_iter_count_t iterations = 0;
+	glitched = false;
+
+	while (iterations < maxIterations) {
+		//the reference escaped before this pixel did
+		if (iterations + 1 >= size) {
+			glitched = true;
+			break;
+		}
+
+		const fd_mandelfloat_t tr = (Zr[iterations] * dzr - Zi[iterations] * dzi) * 2.0 + (dzr * dzr - dzi * dzi) + dcr;
+		dzi = (Zr[iterations] * dzi + Zi[iterations] * dzr) * 2.0 + (dzr + dzr) * dzi + dci;
+		dzr = tr;
+		++iterations;
+
+		zr = Zr[iterations] + dzr;
+		zi = Zi[iterations] + dzi;
+		const fd_mandelfloat_t mag = zr * zr + zi * zi;
+		if (mag > four)
+			break;
+
+		if (mag < glitch[iterations]) {
+			glitched = true;
+			break;
+		}
+	}
+	return iterations;
+}
+
+void Perturbation::iteratePixels(const Frame& frame, const ReferenceOrbit& reference, const std::vector<size_t>& pixels, const fd_dim_t& fromY, fd_iter_count_t* iterations, std::vector<size_t>& glitched) const {
+	const fd_mandelfloat_t stepr = frame.stepr_;
+	const fd_mandelfloat_t stepi = frame.stepi_;
+	bool isGlitched = false;
+
+	for (const size_t& pixel : pixels) {
+		const fd_coord_t dx = fd_coord_t(pixel % width_) - fd_coord_t(reference.x_);
+		const fd_coord_t dy = fd_coord_t(fromY + pixel / width_) - fd_coord_t(reference.y_);
+		iterations[pixel] = iterate(reference, frame.maxIterations_, dx * stepr, dy * stepi, isGlitched);
+		if (isGlitched)
+			glitched.push_back(pixel);
+	}
+}
+
+void Perturbation::iterateSlice(const fd_dim_t& fromY, const fd_dim_t& toY, fd_iter_count_t* iterations, Scratch& scratch) const {
+	std::shared_ptr<const Frame> frame = std::atomic_load(&frame_);
+	assert(frame);
+
+	std::vector<size_t>& pixels = scratch.pixels_;
+	std::vector<size_t>& glitched = scratch.glitched_;
+	pixels.resize((toY - fromY) * width_);
+	glitched.clear();
+	for (size_t i = 0; i < pixels.size(); ++i)
+		pixels[i] = i;
+
+	iteratePixels(*frame, frame->reference_, pixels, fromY, iterations, glitched);
+
+	//iterate the glitched pixels against the secondary references of the frame until all are resolved or we run out
+	//of references. once the slice has tried all that other slices picked, the next one is picked among its own
+	//glitched pixels: the one that survived longest. if a shared reference doesn't resolve any pixel of the slice, it
+	//was picked for the glitches of another part of the frame and the slice picks the rest of its references itself.
+	//a reference never glitches against itself so every one of those makes progress.
+	bool shared = true;
+	for (size_t r = 0; r + 1 < maxReferences_ && !glitched.empty(); ++r) {
+		pixels.swap(glitched);
+		glitched.clear();
+
+		size_t pixel = pixels.front();
+		for (const size_t& p : pixels) {
+			if (iterations[p] > iterations[pixel])
+				pixel = p;
+		}
+		const fd_dim_t x = pixel % width_;
+		const fd_dim_t y = fromY + pixel / width_;
+		if (shared) {
+			iteratePixels(*frame, *secondaryReference(*frame, r, x, y), pixels, fromY, iterations, glitched);
+			shared = glitched.size() < pixels.size();
+		} else {
+			iteratePixels(*frame, frame->makeReference(x, y), pixels, fromY, iterations, glitched);
+		}
+	}
+}
+
+//the secondary reference with the given index. if there is none yet it is calculated at pixel (x, y). that happens
+//under the lock of the frame, so every reference is calculated once. slices that wait for it would need it next anyway.
+std::shared_ptr<const ReferenceOrbit> Perturbation::secondaryReference(const Frame& frame, const size_t& index, const fd_dim_t& x, const fd_dim_t& y) const {
+	std::unique_lock<std::mutex> lock(frame.mutex_);
+	assert(index <= frame.secondary_.size());
+	if (index == frame.secondary_.size())
+		frame.secondary_.push_back(std::make_shared<const ReferenceOrbit>(frame.makeReference(x, y)));
+	return frame.secondary_[index];
+}
+#endif
+
+} /* namespace fractaldive */
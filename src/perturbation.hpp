@@ -0,0 +1,100 @@
+#ifndef SRC_PERTURBATION_HPP_
+#define SRC_PERTURBATION_HPP_
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "types.hpp"
+
+namespace fractaldive {
+
+#ifndef _FIXEDPOINT
+//a high precision orbit Z_n of a reference point, rounded to fd_mandelfloat_t.
+//it ends at the iteration the reference escaped or at the maximum iteration count.
+class ReferenceOrbit {
+public:
+	fd_dim_t x_;
+	fd_dim_t y_;
+	std::vector<fd_mandelfloat_t> zr_;
+	std::vector<fd_mandelfloat_t> zi_;
+	//squared magnitude under which a pixel orbit has lost too much precision relative to the reference (glitch)
+	std::vector<fd_mandelfloat_t> glitch_;
+
+	ReferenceOrbit(const fd_dim_t& x, const fd_dim_t& y, const fd_bigfloat_t& cr, const fd_bigfloat_t& ci, const fd_iter_count_t& maxIterations);
+
+	size_t size() const {
+		return zr_.size();
+	}
+};
+
+//deep zoom renderer based on perturbation theory. one reference orbit is calculated per frame in fd_bigfloat_t and all
+//pixels are iterated as fd_mandelfloat_t deltas against it: d(n+1) = 2 * Z(n) * d(n) + d(n)^2 + dc.
+//pixels that glitch (lose precision against the reference or outlive it) are iterated again against further
+//references picked among them, which are shared by all slices of the frame. what is still glitched after that is left
+//to the caller.
+class Perturbation {
+private:
+	//everything a slice needs to render a frame. replaced as a whole by prepare() so slices of the previous frame
+	//that are still running keep a consistent state.
+	struct Frame {
+		fd_iter_count_t maxIterations_;
+		//c of pixel (0,0) and the distance between two pixels
+		fd_bigfloat_t originr_;
+		fd_bigfloat_t origini_;
+		fd_bigfloat_t stepr_;
+		fd_bigfloat_t stepi_;
+		ReferenceOrbit reference_;
+		//the references of the glitched pixels in the order they were picked, at most maxReferences_ - 1. the first
+		//slice that runs out of them adds the next one.
+		mutable std::mutex mutex_;
+		mutable std::vector<std::shared_ptr<const ReferenceOrbit>> secondary_;
+
+		Frame(const fd_bigfloat_t& originr, const fd_bigfloat_t& origini, const fd_bigfloat_t& stepr, const fd_bigfloat_t& stepi, const fd_iter_count_t& maxIterations, ReferenceOrbit&& reference) :
+				maxIterations_(maxIterations),
+				originr_(originr),
+				origini_(origini),
+				stepr_(stepr),
+				stepi_(stepi),
+				reference_(std::move(reference)) {
+		}
+
+		ReferenceOrbit makeReference(const fd_dim_t& x, const fd_dim_t& y) const {
+			return ReferenceOrbit(x, y, originr_ + stepr_ * x, origini_ + stepi_ * y, maxIterations_);
+		}
+	};
+
+public:
+	//the pixels of a slice that are iterated and those that glitched. kept by the caller per thread, so a slice
+	//doesn't allocate. after iterateSlice() glitched_ holds the pixels no reference could resolve.
+	struct Scratch {
+		std::vector<size_t> pixels_;
+		std::vector<size_t> glitched_;
+	};
+private:
+	fd_dim_t width_;
+	fd_dim_t height_;
+	size_t maxReferences_;
+	std::shared_ptr<const Frame> frame_;
+
+	fd_iter_count_t iterate(const ReferenceOrbit& reference, const fd_iter_count_t& maxIterations, const fd_mandelfloat_t& dcr, const fd_mandelfloat_t& dci, bool& glitched) const;
+	void iteratePixels(const Frame& frame, const ReferenceOrbit& reference, const std::vector<size_t>& pixels, const fd_dim_t& fromY, fd_iter_count_t* iterations, std::vector<size_t>& glitched) const;
+	std::shared_ptr<const ReferenceOrbit> secondaryReference(const Frame& frame, const size_t& index, const fd_dim_t& x, const fd_dim_t& y) const;
+	ReferenceOrbit longestReference(const fd_bigfloat_t& originr, const fd_bigfloat_t& origini, const fd_bigfloat_t& stepr, const fd_bigfloat_t& stepi, const fd_iter_count_t& maxIterations) const;
+public:
+	Perturbation(const fd_dim_t& width, const fd_dim_t& height, const size_t& maxReferences) :
+			width_(width), height_(height), maxReferences_(maxReferences) {
+	}
+
+	//calculates the frame reference orbit, at the center of the frame unless that escapes early
+	void prepare(const fd_bigfloat_t& originr, const fd_bigfloat_t& origini, const fd_bigfloat_t& stepr, const fd_bigfloat_t& stepi, const fd_iter_count_t& maxIterations);
+	//iterates the rows [fromY, toY) into iterations and corrects the glitches of those rows as far as the references go.
+	//the pixels that are left glitched (indices relative to fromY) end up in scratch.glitched_.
+	void iterateSlice(const fd_dim_t& fromY, const fd_dim_t& toY, fd_iter_count_t* iterations, Scratch& scratch) const;
+};
+#endif
+
+} /* namespace fractaldive */
+
+#endif /* SRC_PERTURBATION_HPP_ */
@@ -0,0 +1,99 @@
+//DoubleDouble depends on the exact order of floating point operations, which -ffast-math (hardcore builds) gives up.
+//this has to precede the includes so that the kernel instances below and everything they inline are affected.
+#if defined(__clang__)
+#pragma float_control(precise, on)
+#elif defined(__GNUC__)
+#pragma GCC optimize("no-fast-math")
+#endif
+
+#include "precision.hpp"
+
+#include <cstring>
+#include <limits>
+
+#include "kernel.hpp"
+#include "doubledouble.hpp"
+
+namespace fractaldive {
+
+const char* precision_name(const Precision& precision) {
+	switch (precision) {
+	case PRECISION_FLOAT:
+		return "float";
+	case PRECISION_DOUBLE_DOUBLE:
+		return "double-double";
+	case PRECISION_QUAD:
+		return "quad";
+	default:
+		return "double";
+	}
+}
+
+bool parse_precision(const char* name, Precision& precision) {
+	const Precision precisions[] = { PRECISION_FLOAT, PRECISION_DOUBLE, PRECISION_DOUBLE_DOUBLE, PRECISION_QUAD };
+	for (const Precision& p : precisions) {
+		if (std::strcmp(name, precision_name(p)) == 0) {
+			precision = p;
+			return true;
+		}
+	}
+	return false;
+}
+
+#ifndef _FIXEDPOINT
+//std::numeric_limits isn't specialized for __float128 in strict ansi mode
+template<>
+struct Periodicity<fd_bigfloat_t> {
+	static fd_bigfloat_t epsilon() {
+		return fd_bigfloat_t(std::ldexp(1.0, -112)) * 64;
+	}
+};
+
+Precision select_precision(const fd_mandelfloat_t& step, const fd_mandelfloat_t& extent, const size_t& guardBits) {
+	//the distance between two representable values around extent relative to the pixel spacing
+	const fd_mandelfloat_t resolution = extent * std::ldexp(1.0, guardBits) / step;
+	if (resolution * std::numeric_limits<float>::epsilon() <= 1)
+		return PRECISION_FLOAT;
+	if (resolution * std::numeric_limits<double>::epsilon() <= 1)
+		return PRECISION_DOUBLE;
+	if (resolution * std::ldexp(1.0, -104) <= 1)
+		return PRECISION_DOUBLE_DOUBLE;
+	return PRECISION_QUAD;
+}
+
+template<typename T, typename F>
+fd_iter_count_t mandelbrot_point_kernel(const fd_bigfloat_t& pointr, const fd_bigfloat_t& pointi, const fd_iter_count_t& currentIt, const bool& checkInterior, const FormulaParams& params) {
+	return mandelbrot_point<T, F>(T(pointr), T(pointi), currentIt, checkInterior, params);
+}
+
+template<typename F>
+point_kernel_t select_point_kernel(const Precision& precision) {
+	switch (precision) {
+	case PRECISION_FLOAT:
+		return mandelbrot_point_kernel<float, F>;
+	case PRECISION_DOUBLE_DOUBLE:
+		return mandelbrot_point_kernel<DoubleDouble, F>;
+	case PRECISION_QUAD:
+		return mandelbrot_point_kernel<fd_bigfloat_t, F>;
+	default:
+		return mandelbrot_point_kernel<double, F>;
+	}
+}
+
+point_kernel_t select_point_kernel(const Precision& precision, const Formula& formula) {
+	switch (formula) {
+	case FORMULA_JULIA:
+		return select_point_kernel<Julia>(precision);
+	case FORMULA_BURNING_SHIP:
+		return select_point_kernel<BurningShip>(precision);
+	case FORMULA_MULTIBROT3:
+		return select_point_kernel<Multibrot<3>>(precision);
+	case FORMULA_MULTIBROT4:
+		return select_point_kernel<Multibrot<4>>(precision);
+	default:
+		return select_point_kernel<Mandelbrot>(precision);
+	}
+}
+#endif
+
+} /* namespace fractaldive */
@@ -0,0 +1,36 @@
+#ifndef SRC_PRECISION_HPP_
+#define SRC_PRECISION_HPP_
+
+#include <cstddef>
+
+#include "types.hpp"
+#include "formula.hpp"
+
+namespace fractaldive {
+
+//the floating point types frames can be iterated with, from the cheapest to the most precise
+enum Precision {
+	PRECISION_FLOAT,
+	PRECISION_DOUBLE,
+	PRECISION_DOUBLE_DOUBLE,
+	PRECISION_QUAD
+};
+
+const char* precision_name(const Precision& precision);
+//parses a name as returned by precision_name(). returns false for unknown names.
+bool parse_precision(const char* name, Precision& precision);
+
+#ifndef _FIXEDPOINT
+//the cheapest precision that resolves coordinates of magnitude up to "extent" at least 2^guardBits times finer than
+//the pixel spacing "step". the guard bits absorb the rounding errors the orbit accumulates.
+Precision select_precision(const fd_mandelfloat_t& step, const fd_mandelfloat_t& extent, const size_t& guardBits);
+
+typedef fd_iter_count_t (*point_kernel_t)(const fd_bigfloat_t& pointr, const fd_bigfloat_t& pointi, const fd_iter_count_t& currentIt, const bool& checkInterior, const FormulaParams& params);
+//the scalar kernel instance for the given precision and formula. the point is rounded to that precision once and
+//iterated with it.
+point_kernel_t select_point_kernel(const Precision& precision, const Formula& formula);
+#endif
+
+} /* namespace fractaldive */
+
+#endif /* SRC_PRECISION_HPP_ */
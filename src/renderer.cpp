@@ -8,6 +8,7 @@
 
 #include "printer.hpp"
 #include "util.hpp"
+#include "kernel.hpp"
 #ifndef _AMIGA
 #include "digital_filters.hpp"
 #endif
@@ -23,147 +24,1030 @@ inline fd_iter_count_t Renderer::getCurrentMaxIterations() const {
 	return maxIterations_;
 }
 
+const fd_image_pix_t* Renderer::acquireFrame() {
+	std::unique_lock<std::mutex> lock(frameMutex_);
+	++holds_[published_];
+	return frames_[published_];
+}
+
+void Renderer::releaseFrame(const fd_image_pix_t* frame) {
+	std::unique_lock<std::mutex> lock(frameMutex_);
+	for (size_t i = 0; i < frames_.size(); ++i) {
+		if (frames_[i] == frame) {
+			assert(holds_[i] > 0);
+			--holds_[i];
+		}
+	}
+}
+
+bool Renderer::isFrameDone() {
+	return frameTasks_.isDone();
+}
+
+bool Renderer::waitForFrame(const fd_highres_tick_t& millis) {
+	return frameTasks_.waitFor(millis * 1000);
+}
+
+//makes the frame in imageData_ the newest complete one. called by the last task of a frame, so the canvas gets it
+//without waiting for the next call to render().
+void Renderer::publish() {
+	std::unique_lock<std::mutex> lock(frameMutex_);
+	published_ = rendering_;
+}
+
+//points imageData_ to a buffer that is neither the published frame nor acquired. the previous frame has to be
+//complete. there are enough buffers for every frame that may be held at once.
+void Renderer::selectBuffer() {
+	std::unique_lock<std::mutex> lock(frameMutex_);
+	for (size_t i = 1; i < frames_.size(); ++i) {
+		const size_t buffer = (published_ + i) % frames_.size();
+		if (holds_[buffer] == 0) {
+			rendering_ = buffer;
+			break;
+		}
+	}
+	assert(rendering_ != published_ && holds_[rendering_] == 0);
+	imageData_ = frames_[rendering_];
+}
+
 // Generate the fractal image
 void Renderer::render() {
-	if (ThreadPool::cores() > 1) {
+	//the previous frame is the source of reprojection and shares the iteration buffers
+	waitForSlices();
+	accumulateThreadStats();
+	frameIterations_ = getCurrentMaxIterations();
+#ifndef _FIXEDPOINT
+	previousCoordinates_.swap(coordinates_);
+#endif
+	coordinates_.generate(camera_);
+#ifndef _FIXEDPOINT
+	const fd_float_t zoom = camera_.getZoom();
+	preparePrecision();
+	//once double isn't precise enough any more perturbation takes over, it is a lot faster than iterating every pixel
+	//with one of the higher precisions. the reference orbit and the deltas are those of the mandelbrot set only.
+	if (config_.formula_ == FORMULA_MANDELBROT && config_.perturbationZoom_ > 0 && (zoom >= config_.perturbationZoom_ || (config_.autoPrecision_ && precision_ > PRECISION_DOUBLE))) {
+		//derive the frame from the exact camera position. the double based getters don't have enough bits at that depth
+		perturbation_.prepare(camera_.getOriginR(), camera_.getOriginI(), camera_.getStepR(), camera_.getStepI(), frameIterations_);
+		perturbate_ = true;
+	} else {
+		perturbate_ = false;
+	}
+	//the derivatives are tracked by a scalar kernel for float and double
+	distance_ = config_.distanceEstimation_ && !perturbate_ && precision_ <= PRECISION_DOUBLE && has_distance_estimate(config_.formula_);
+	if (distance_)
+		distances_.resize(config_.width_ * config_.height_, 0);
+	//the mirrored rows take the coordinates of their sources as reprojection leaves them
+	prepareReprojection();
+	prepareSymmetry();
+#else
+	prepareSymmetry();
+#endif
+	iterations_.reserve(frameIterations_);
+	selectBuffer();
+	prepareScratch();
+	if (ThreadPool::size() > 1) {
+		const Schedule schedule = config_.schedule_;
+		frameStart_ = get_highres_tick();
+		frameSchedule_ = schedule;
+		size_t tasks = 0;
+		if (schedule == SCHEDULE_STEALING)
+			tasks = scheduleTiles();
+		else if (schedule == SCHEDULE_COST)
+			tasks = scheduleCost();
+		else
+			tasks = scheduleStripes();
+
+		busy_.assign(tasks, 0);
+		finished_.assign(tasks, frameStart_);
 		//use a thread pool to reduce thread start overhead
-		ThreadPool& tpool = ThreadPool::getInstance();
-		size_t tpsize = tpool.size();
-		//slice the image into horizontal stripes
-		fd_dim_t sliceHeight = std::floor(fd_float_t(config_.height_) / tpsize);
-		fd_dim_t remainder = (config_.height_ % sliceHeight);
-		for (size_t i = 0; i < tpsize + 1; ++i) {
-			if (i == tpsize) {
-				if(remainder > 0)
-					sliceHeight = remainder;
-				else
-					break;
+		ThreadPool::getInstance().parallel_for(frameTasks_, 0, tasks, &Renderer::runTask, this);
+	} else {
+		renderSlice(renderFrom_, renderTo_);
+		mirrorRows();
+		publish();
+	}
+}
+
+//the entry point of the tasks of a frame: a worker of SCHEDULE_STEALING or one of the regions of the other schedules
+void Renderer::runTask(void* renderer, size_t task) {
+	Renderer* r = static_cast<Renderer*>(renderer);
+	if (r->frameSchedule_ == SCHEDULE_STEALING)
+		r->renderTiles(task);
+	else
+		r->renderRegion(task);
+}
+
+//slices the rows to calculate into one horizontal stripe per thread (and one for the remainder)
+size_t Renderer::scheduleStripes() {
+	const size_t tpsize = ThreadPool::size();
+	const fd_dim_t height = renderTo_ - renderFrom_;
+	fd_dim_t sliceHeight = std::floor(fd_float_t(height) / tpsize);
+	fd_dim_t remainder = height - (sliceHeight * tpsize);
+	regions_.clear();
+	for (size_t i = 0; i < tpsize + 1; ++i) {
+		fd_dim_t fromY = renderFrom_ + sliceHeight * i;
+		fd_dim_t toY = fromY + sliceHeight;
+		if (i == tpsize) {
+			if(remainder > 0)
+				toY = fromY + remainder;
+			else
+				break;
+		} else if (sliceHeight == 0) {
+			continue;
+		}
+		regions_.push_back({fromY, toY});
+	}
+	//the slices are counted up front, so the last one to finish knows it is the last
+	unrenderedSlices_ = regions_.size();
+	return regions_.size();
+}
+
+void Renderer::renderRegion(const size_t& task) {
+	const fd_highres_tick_t start = get_highres_tick();
+	renderSlice(regions_[task].first, regions_[task].second);
+	finishSlice();
+	finished_[task] = get_highres_tick();
+	busy_[task] = finished_[task] - start;
+}
+
+//the number of rows of the tiles of SCHEDULE_STEALING/SCHEDULE_COST. the render modes subdivide tiles of their own,
+//which shouldn't be cut.
+fd_dim_t Renderer::tileRows() const {
+	fd_dim_t rows = config_.scheduleTile_;
+	if (config_.renderMode_ == RENDER_RECTANGLES)
+		rows = std::max(rows, config_.rectangleTile_);
+	else if (config_.renderMode_ == RENDER_GUESSING)
+		rows = ((rows + config_.guessingStep_ - 1) / config_.guessingStep_) * config_.guessingStep_;
+	return rows;
+}
+
+//folds the cost per busy tick of the workers in the last frame of SCHEDULE_STEALING into the moving average of their
+//speed. a worker that didn't render anything keeps its speed.
+void Renderer::updateWorkerSpeeds() {
+	const size_t workers = ThreadPool::size();
+	if (workerSpeed_.size() != workers) {
+		workerCost_.assign(workers, 0);
+		workerBusy_.assign(workers, 0);
+		workerSpeed_.assign(workers, 0);
+		return;
+	}
+	for (size_t w = 0; w < workers; ++w) {
+		if (workerBusy_[w] > 0 && workerCost_[w] > 0) {
+			const fd_float_t speed = fd_float_t(workerCost_[w]) / workerBusy_[w];
+			workerSpeed_[w] = workerSpeed_[w] > 0 ? (workerSpeed_[w] * 3 + speed) / 4 : speed;
+		}
+		workerCost_[w] = 0;
+		workerBusy_[w] = 0;
+	}
+}
+
+//cuts the rows to calculate into tiles and deals them out in contiguous runs, one deque per thread. with pinned
+//threads the runs are as long as the speed of the worker allows (e.g. performance vs. efficiency cores), otherwise
+//of equal length. stealing balances what the estimate misses.
+size_t Renderer::scheduleTiles() {
+	const size_t workers = ThreadPool::size();
+	const fd_dim_t rows = tileRows();
+	const size_t tiles = (renderTo_ - renderFrom_ + rows - 1) / rows;
+	if (tileQueues_.size() != workers)
+		std::vector<TileQueue>(workers).swap(tileQueues_);
+	updateWorkerSpeeds();
+
+	//the runs end at the tiles where the cumulative share of the workers up to them ends
+	std::vector<size_t> ends(workers);
+	fd_float_t total = 0;
+	bool weighted = config_.pin_ != PIN_NONE;
+	for (const fd_float_t& speed : workerSpeed_) {
+		weighted = weighted && speed > 0;
+		total += speed;
+	}
+	fd_float_t sum = 0;
+	for (size_t w = 0; w < workers; ++w) {
+		sum += weighted ? workerSpeed_[w] : 1;
+		ends[w] = w + 1 == workers ? tiles : size_t(tiles * sum / (weighted ? total : workers));
+	}
+
+	size_t begin = 0;
+	for (size_t w = 0; w < workers; ++w) {
+		std::deque<std::pair<fd_dim_t, fd_dim_t>>& queue = tileQueues_[w].tiles_;
+		queue.clear();
+		for (size_t t = begin; t < ends[w]; ++t) {
+			const fd_dim_t fromY = renderFrom_ + t * rows;
+			queue.push_back({fromY, std::min(fromY + rows, renderTo_)});
+		}
+		begin = ends[w];
+	}
+
+	unrenderedSlices_ = tiles;
+	return workers;
+}
+
+//cuts the rows to calculate into one contiguous run of tiles per thread, so that every run costs about the same. the
+//cost of a tile is predicted by the cost of its rows in the previous frame, which is nearly the same frame. there is
+//no scheduling overhead beyond that of the stripes. a frame with rows that weren't rendered before and have no
+//prediction (e.g. the first one) is cut into stripes.
+size_t Renderer::scheduleCost() {
+	const size_t workers = ThreadPool::size();
+	const fd_dim_t rows = tileRows();
+
+	uint64_t total = 0;
+	for (fd_dim_t y = renderFrom_; y < renderTo_; ++y) {
+		if (rowCosts_[y] == 0)
+			return scheduleStripes();
+		total += rowCosts_[y];
+	}
+	regions_.clear();
+
+	uint64_t cost = 0;
+	fd_dim_t fromY = renderFrom_;
+	for (fd_dim_t y = renderFrom_; y < renderTo_; y += rows) {
+		const fd_dim_t toY = std::min(y + rows, renderTo_);
+		for (fd_dim_t r = y; r < toY; ++r)
+			cost += rowCosts_[r];
+		//cut as soon as the runs so far have their share of the total cost
+		if (regions_.size() + 1 < workers && cost * workers >= total * (regions_.size() + 1)) {
+			regions_.push_back({fromY, toY});
+			fromY = toY;
+		}
+	}
+	if (fromY < renderTo_)
+		regions_.push_back({fromY, renderTo_});
+
+	unrenderedSlices_ = regions_.size();
+	return regions_.size();
+}
+
+//the tasks aren't bound to workers, so a task works on the deque of the worker that runs it. that is the one whose
+//speed its run was sized by.
+void Renderer::renderTiles(const size_t& task) {
+	const size_t worker = ThreadPool::workerIndex() < tileQueues_.size() ? ThreadPool::workerIndex() : task;
+	fd_highres_tick_t busy = 0;
+	uint64_t cost = 0;
+	std::pair<fd_dim_t, fd_dim_t> tile;
+	while (takeTile(worker, tile)) {
+		const fd_highres_tick_t start = get_highres_tick();
+		renderSlice(tile.first, tile.second);
+		for (fd_dim_t y = tile.first; y < tile.second; ++y)
+			cost += rowCosts_[y];
+		finishSlice();
+		busy += get_highres_tick() - start;
+	}
+	busy_[task] = busy;
+	finished_[task] = get_highres_tick();
+	workerCost_[worker] += cost;
+	workerBusy_[worker] += busy;
+}
+
+//takes the next tile of the worker's own deque or steals the last one of another worker. the tiles are all dealt out
+//before the workers start, so once every deque is empty the frame is done.
+bool Renderer::takeTile(const size_t& worker, std::pair<fd_dim_t, fd_dim_t>& tile) {
+	{
+		TileQueue& own = tileQueues_[worker];
+		std::unique_lock<std::mutex> lock(own.mutex_);
+		if (!own.tiles_.empty()) {
+			tile = own.tiles_.front();
+			own.tiles_.pop_front();
+			return true;
+		}
+	}
+	for (size_t i = 1; i < tileQueues_.size(); ++i) {
+		TileQueue& victim = tileQueues_[(worker + i) % tileQueues_.size()];
+		std::unique_lock<std::mutex> lock(victim.mutex_);
+		if (!victim.tiles_.empty()) {
+			tile = victim.tiles_.back();
+			victim.tiles_.pop_back();
+			return true;
+		}
+	}
+	return false;
+}
+
+//the slice that finishes last copies the mirrored rows, which may come from any of the slices
+void Renderer::finishSlice() {
+	if (--unrenderedSlices_ == 0) {
+		mirrorRows();
+		publish();
+	}
+}
+
+//finds the rows that are mirror images of other rows. fd_coord_t is integral, so the real axis is either outside of
+//the frame or exactly on row -originY, and rows y and 2 * axis - y are conjugates. the coordinates of the mirrored
+//rows are set to the exact negation of their source rows, so that they are the same as if they were calculated
+//(for floating point types, whose rounding is symmetric). runs after prepareReprojection(), which may move the
+//source rows.
+void Renderer::prepareSymmetry() {
+	const fd_coord_t height = config_.height_;
+	renderFrom_ = 0;
+	renderTo_ = height;
+	mirrorFrom_ = mirrorTo_ = 0;
+#ifndef _FIXEDPOINT
+	if (perturbate_)
+		return;
+#endif
+	if (!symmetry_ || !is_conjugate_symmetric(config_.formula_, config_.formulaParams_))
+		return;
+
+#ifndef _FIXEDPOINT
+	//the camera keeps pixel (0,0) a whole number of rows away from the real axis
+	const fd_bigfloat_t row = -camera_.getOriginI() / camera_.getStepI();
+	if (row < fd_bigfloat_t(0.5) || row > fd_bigfloat_t(height - 2.5))
+		return;
+	const fd_coord_t axis = std::round(double(row));
+#else
+	const fd_coord_t axis = -camera_.getOriginY();
+	if (axis < 1 || axis > height - 2)
+		return;
+#endif
+
+	mirrorSum_ = 2 * axis;
+	if (axis <= height - 1 - axis) {
+		mirrorFrom_ = 0;
+		mirrorTo_ = axis;
+		renderFrom_ = axis;
+	} else {
+		mirrorFrom_ = axis + 1;
+		mirrorTo_ = height;
+		renderTo_ = axis + 1;
+	}
+
+	for (fd_dim_t y = mirrorFrom_; y < mirrorTo_; ++y) {
+		coordinates_.pointi_[y] = -coordinates_.pointi_[mirrorSum_ - y];
+#ifndef _FIXEDPOINT
+		coordinates_.bigPointi_[y] = -coordinates_.bigPointi_[mirrorSum_ - y];
+#endif
+	}
+}
+
+//copies the mirrored rows once all of their sources are rendered and colors them. the rendered and the mirrored rows
+//are colored as slices of their own, so the color filter doesn't reach across the axis (see colorRows()).
+void Renderer::mirrorRows() {
+	const fd_dim_t width = config_.width_;
+	if (mirrorFrom_ == mirrorTo_)
+		return;
+
+	for (fd_dim_t y = mirrorFrom_; y < mirrorTo_; ++y) {
+		iterations_.copy(y * width, (mirrorSum_ - y) * width, width);
+		rowCosts_[y] = rowCosts_[mirrorSum_ - y];
+	}
+#ifndef _FIXEDPOINT
+	if (distance_) {
+		for (fd_dim_t y = mirrorFrom_; y < mirrorTo_; ++y)
+			std::copy(distances_.begin() + (mirrorSum_ - y) * width, distances_.begin() + (mirrorSum_ - y + 1) * width, distances_.begin() + y * width);
+	}
+#endif
+	colorSlice(mirrorFrom_, mirrorTo_);
+}
+
+void Renderer::renderSlice(const fd_dim_t& fromY, const fd_dim_t& toY) {
+	const fd_dim_t width = config_.width_;
+	const fd_iter_count_t currentIt = frameIterations_;
+	std::vector<fd_iter_count_t>& sliceIterations = scratch().iterations_;
+	sliceIterations.resize((toY - fromY) * width);
+
+	iterateSlice(fromY, toY, currentIt, sliceIterations.data());
+	iterations_.store(fromY * width, sliceIterations.data(), sliceIterations.size());
+	colorSlice(fromY, toY);
+
+	//the prediction of the cost of the next frame (see scheduleCost()). the render modes count the pixels they
+	//calculate themselves, here only the pixels copied by reprojection are left out.
+	if (config_.schedule_ != SCHEDULE_STRIPES && !subdivides()) {
+		for (fd_dim_t y = fromY; y < toY; ++y) {
+			const fd_iter_count_t* row = sliceIterations.data() + (y - fromY) * width;
+			const fd_coord_t* sourceX = nullptr;
+#ifndef _FIXEDPOINT
+			if (reproject_ && sourceY_[y] >= 0)
+				sourceX = sourceX_.data();
+#endif
+			uint64_t cost = width;
+			for (fd_dim_t x = 0; x < width; ++x) {
+				if (sourceX == nullptr || sourceX[x] < 0)
+					cost += row[x];
 			}
-			//start a worker thread
-			tpool.enqueue([&](const size_t& i, const fd_dim_t& width, const fd_dim_t& sliceHeight) {
-#ifndef _AMIGA
-				LowPassFilter lpf(0.01, 2 * M_PI * 100000);
+			rowCosts_[y] = cost;
+		}
+	}
+}
+
+//true if the slices are rendered by RENDER_RECTANGLES/RENDER_GUESSING (see iterateSlice())
+bool Renderer::subdivides() const {
+#ifndef _FIXEDPOINT
+	if (perturbate_ || distance_)
+		return false;
 #endif
+	return config_.renderMode_ != RENDER_FULL;
+}
 
-				fd_iter_count_t currentIt = getCurrentMaxIterations();
-				fd_iter_count_t iterations = 0;
-				fd_coord_t yoff = 0;
+void Renderer::recordCosts(const fd_dim_t& fromY, const fd_dim_t& toY, const uint64_t* rowIterations) {
+	if (config_.schedule_ == SCHEDULE_STRIPES)
+		return;
+	for (fd_dim_t y = fromY; y < toY; ++y)
+		rowCosts_[y] = config_.width_ + rowIterations[y - fromY];
+}
+
+void Renderer::colorize() {
+	waitForSlices();
+	selectBuffer();
+	colorSlice(0, config_.height_);
+	publish();
+}
+
+void Renderer::colorSlice(const fd_dim_t& fromY, const fd_dim_t& toY) {
+	if (iterations_.isCompact())
+		colorRows(iterations_.compact(), fromY, toY);
+	else
+		colorRows(iterations_.wide(), fromY, toY);
+}
 
-				for (fd_dim_t y = sliceHeight * i; y < (sliceHeight * i + sliceHeight); y++) {
-					yoff = y * width;
-					for (fd_dim_t x = 0; x < width; x++) {
-						iterations = mandelbrot(x, y, currentIt);
-						if(iterations < currentIt) {
-							size_t pSize = palette_.size();
-							if(pSize > 0) {
+template<typename T>
+void Renderer::colorRows(const T* iterations, const fd_dim_t& fromY, const fd_dim_t& toY) {
 #ifndef _AMIGA
-								imageData_[yoff + x] = filter(lpf, yoff > 0 ? imageData_[yoff - width + x] : 0, palette_[iterations % pSize]);
-#else
-								imageData_[yoff + x] = iterations % palette_.size();
-#endif
-							} else {
-								imageData_[yoff + x] = filter(lpf, yoff > 0 ? imageData_[yoff - width + x] : 0, 0);
-							}
-						} else {
-							imageData_[yoff + x] = filter(lpf, yoff > 0 ? imageData_[yoff - width + x] : 0, 0);
-						}
-					}
-				}
-			}, i, config_.width_, sliceHeight);
-		}
-	} else {
+	LowPassFilter lpf(0.01, 2 * M_PI * 100000);
+#endif
+	const fd_dim_t width = config_.width_;
+	const fd_iter_count_t currentIt = frameIterations_;
+	const size_t pSize = palette_.size();
+	fd_iter_count_t it = 0;
+	fd_coord_t yoff = 0;
+
+	//the row above the slice belongs to another tile, which may still be colored or not even rendered yet. the
+	//vertical filter starts at the first row of the slice like it does at the top of the image.
+	for (fd_dim_t y = fromY; y < toY; y++) {
+		yoff = y * width;
+		for (fd_dim_t x = 0; x < width; x++) {
+			it = iterations[yoff + x];
+			if (it < currentIt && pSize > 0) {
 #ifndef _AMIGA
-		LowPassFilter lpf(0.01, 2 * M_PI * 100000);
-#endif
-		fd_iter_count_t currentIt = getCurrentMaxIterations();
-		fd_iter_count_t iterations = 0;
-		fd_coord_t yoff = 0;
-
-		for (fd_dim_t y = 0; y < config_.height_; y++) {
-			yoff = y * config_.width_;
-			for (fd_dim_t x = 0; x < config_.width_; x++) {
-				iterations = mandelbrot(x, y, currentIt);
-				if (iterations < currentIt) {
-					size_t pSize = palette_.size();
-					if(pSize > 0) {
+				imageData_[yoff + x] = filter(lpf, y > fromY ? imageData_[yoff - width + x] : 0, palette_[it % pSize]);
+#else
+				imageData_[yoff + x] = it % pSize;
+#endif
+			} else {
 #ifndef _AMIGA
-						imageData_[yoff + x] = lpf.update(palette_[iterations % pSize]);
+				imageData_[yoff + x] = filter(lpf, y > fromY ? imageData_[yoff - width + x] : 0, 0);
 #else
-						imageData_[yoff + x] = iterations % pSize;
+				imageData_[yoff + x] = 0;
 #endif
-					} else {
-						imageData_[yoff + x] = 0;
-					}
-				} else {
-					imageData_[yoff + x] = 0;
-				}
 			}
 		}
 	}
 }
 
-#if 0
-// LUT experiments for AMIGA. doesn't make a real difference yet.
-static std::vector<fd_mandelfloat_t> LUT(std::pow(2, 8),0);
-inline fd_mandelfloat_t Renderer::square(const fd_mandelfloat_t& n) const {
-	uint8_t idx = n.GetRawVal() >> 4;
+void Renderer::iterateSlice(const fd_dim_t& fromY, const fd_dim_t& toY, const fd_iter_count_t& currentIt, fd_iter_count_t* iterations) {
+	const fd_dim_t width = config_.width_;
+#ifndef _FIXEDPOINT
+	if (perturbate_) {
+		Perturbation::Scratch& scratch = this->scratch().perturbation_;
+		perturbation_.iterateSlice(fromY, toY, iterations, scratch);
+		//what none of the references resolved is iterated at the precision of the frame instead of keeping the glitched count
+		for (const size_t& pixel : scratch.glitched_)
+			iterations[pixel] = pointKernel_(coordinates_.bigPointr_[pixel % width], coordinates_.bigPointi_[fromY + pixel / width], currentIt, config_.interiorCheck_, config_.formulaParams_);
+		return;
+	}
+	//the distance field needs every pixel
+	if (distance_) {
+		iterateSliceDistance(fromY, toY, currentIt, iterations);
+		return;
+	}
+#endif
+
+	if (config_.renderMode_ == RENDER_RECTANGLES) {
+		iterateSliceRectangles(fromY, toY, currentIt, iterations);
+		return;
+	} else if (config_.renderMode_ == RENDER_GUESSING) {
+		iterateSliceGuessing(fromY, toY, currentIt, iterations);
+		return;
+	}
+
+#ifndef _FIXEDPOINT
+	if (reproject_) {
+		LaneStats stats;
+		iterateSliceReprojected(fromY, toY, currentIt, iterations, stats);
+		laneIterations_ += stats.iterations_;
+		laneSlots_ += stats.slots_;
+		return;
+	}
+
+	//there are no simd kernels beyond double
+	if (config_.kernel_ != KERNEL_SCALAR && precision_ <= PRECISION_DOUBLE) {
+#else
+	if (config_.kernel_ != KERNEL_SCALAR && simdKernel_ != nullptr) {
+#endif
+		LaneStats stats;
+		iterateSliceSimd(fromY, toY, currentIt, iterations, stats);
+		laneIterations_ += stats.iterations_;
+		laneSlots_ += stats.slots_;
+		return;
+	}
+	for (fd_dim_t y = fromY; y < toY; ++y) {
+		for (fd_dim_t x = 0; x < width; ++x) {
+			iterations[(y - fromY) * width + x] = mandelbrot(x, y, currentIt);
+		}
+	}
+}
+
+//Mariani-Silver subdivision: the slice is split into tiles. a tile whose border has a uniform iteration count is
+//filled with it (the set and its level sets are connected), otherwise it is split in two and each half is checked again.
+void Renderer::iterateSliceRectangles(const fd_dim_t& fromY, const fd_dim_t& toY, const fd_iter_count_t& currentIt, fd_iter_count_t* iterations) {
+	const fd_dim_t width = config_.width_;
+	const fd_dim_t tile = config_.rectangleTile_;
+	RectangleBuffer& buffer = scratch().rectangles_;
+	buffer.reset(toY - fromY);
+
+	//trace the borders of all tiles
+	for (fd_dim_t ty = fromY; ty < toY; ty += tile) {
+		const fd_dim_t tyEnd = std::min(ty + tile, toY);
+		for (fd_dim_t tx = 0; tx < width; tx += tile) {
+			const fd_dim_t txEnd = std::min(tx + tile, width);
+			queueRectangle(tx, txEnd, ty, ty + 1, fromY, currentIt, iterations, buffer);
+			if (tyEnd - ty > 1)
+				queueRectangle(tx, txEnd, tyEnd - 1, tyEnd, fromY, currentIt, iterations, buffer);
+			if (tyEnd - ty > 2) {
+				queueRectangle(tx, tx + 1, ty + 1, tyEnd - 1, fromY, currentIt, iterations, buffer);
+				if (txEnd - tx > 1)
+					queueRectangle(txEnd - 1, txEnd, ty + 1, tyEnd - 1, fromY, currentIt, iterations, buffer);
+			}
+			buffer.current_.push_back({tx, txEnd, ty, tyEnd});
+		}
+	}
+	flushRectangles(currentIt, iterations, buffer);
+
+	while (!buffer.current_.empty()) {
+		for (const Rectangle& rect : buffer.current_)
+			subdivideRectangle(rect, fromY, currentIt, iterations, buffer);
+		flushRectangles(currentIt, iterations, buffer);
+		std::swap(buffer.current_, buffer.next_);
+		buffer.next_.clear();
+	}
+
+#ifndef _FIXEDPOINT
+	laneIterations_ += buffer.stats_.iterations_;
+	laneSlots_ += buffer.stats_.slots_;
+#endif
+	filledPixels_ += buffer.filled_;
+	computedPixels_ += buffer.computed_;
+	recordCosts(fromY, toY, buffer.rowIterations_.data());
+}
+
+//the border of the rectangle is known. either fills it, queues its interior or queues the line that splits it and
+//its two halves. iterations is relative to row sliceY.
+void Renderer::subdivideRectangle(const Rectangle& rect, const fd_dim_t& sliceY, const fd_iter_count_t& currentIt, fd_iter_count_t* iterations, RectangleBuffer& buffer) {
+	const fd_dim_t width = config_.width_;
+	const fd_dim_t fromX = rect.fromX_;
+	const fd_dim_t toX = rect.toX_;
+	const fd_dim_t fromY = rect.fromY_;
+	const fd_dim_t toY = rect.toY_;
+	const fd_dim_t w = toX - fromX;
+	const fd_dim_t h = toY - fromY;
+	if (w <= 2 || h <= 2)
+		return;
 
-	auto& p = LUT[idx];
+	fd_iter_count_t* top = iterations + (fromY - sliceY) * width;
+	fd_iter_count_t* bottom = iterations + (toY - 1 - sliceY) * width;
+	const fd_iter_count_t value = top[fromX];
+	bool uniform = true;
+	for (fd_dim_t x = fromX; uniform && x < toX; ++x)
+		uniform = top[x] == value && bottom[x] == value;
+	for (fd_dim_t y = fromY + 1; uniform && y < toY - 1; ++y) {
+		const fd_iter_count_t* row = iterations + (y - sliceY) * width;
+		uniform = row[fromX] == value && row[toX - 1] == value;
+	}
 
-	if(p == 0) {
-		return p = n * n;
+	if (uniform) {
+		for (fd_dim_t y = fromY + 1; y < toY - 1; ++y) {
+			fd_iter_count_t* row = iterations + (y - sliceY) * width;
+			std::fill(row + fromX + 1, row + toX - 1, value);
+		}
+		buffer.filled_ += (w - 2) * (h - 2);
+		return;
+	}
+
+	if (w <= config_.rectangleMinSize_ && h <= config_.rectangleMinSize_) {
+		queueRectangle(fromX + 1, toX - 1, fromY + 1, toY - 1, sliceY, currentIt, iterations, buffer);
+		return;
+	}
+
+	//split the longer side
+	if (w >= h) {
+		const fd_dim_t splitX = fromX + w / 2;
+		queueRectangle(splitX, splitX + 1, fromY + 1, toY - 1, sliceY, currentIt, iterations, buffer);
+		buffer.next_.push_back({fromX, splitX + 1, fromY, toY});
+		buffer.next_.push_back({splitX, toX, fromY, toY});
 	} else {
-		return p;
+		const fd_dim_t splitY = fromY + h / 2;
+		queueRectangle(fromX + 1, toX - 1, splitY, splitY + 1, sliceY, currentIt, iterations, buffer);
+		buffer.next_.push_back({fromX, toX, fromY, splitY + 1});
+		buffer.next_.push_back({fromX, toX, splitY, toY});
 	}
 }
+
+//Fractint style solid guessing: the slice is sampled on a coarse grid. cells whose four corners have the same
+//iteration count are filled, the others are split into four and their new corners are calculated, down to single pixels.
+void Renderer::iterateSliceGuessing(const fd_dim_t& fromY, const fd_dim_t& toY, const fd_iter_count_t& currentIt, fd_iter_count_t* iterations) {
+	const fd_dim_t width = config_.width_;
+	const fd_dim_t step = config_.guessingStep_;
+	RectangleBuffer& buffer = scratch().rectangles_;
+	buffer.reset(toY - fromY);
+	buffer.known_.resize((toY - fromY) * width, 0);
+
+	//the coarse grid. the last row and column close the cells at the border
+	for (fd_dim_t y = fromY; y < toY; y += step) {
+		const fd_dim_t yEnd = std::min(y + step, toY - 1);
+		for (fd_dim_t x = 0; x < width; x += step) {
+			const fd_dim_t xEnd = std::min(x + step, width - 1);
+			guessPixel(x, y, fromY, currentIt, iterations, buffer);
+			guessPixel(xEnd, y, fromY, currentIt, iterations, buffer);
+			guessPixel(x, yEnd, fromY, currentIt, iterations, buffer);
+			guessPixel(xEnd, yEnd, fromY, currentIt, iterations, buffer);
+			buffer.current_.push_back({x, xEnd + 1, y, yEnd + 1});
+		}
+	}
+	flushRectangles(currentIt, iterations, buffer);
+
+	while (!buffer.current_.empty()) {
+		for (const Rectangle& cell : buffer.current_)
+			refineCell(cell, fromY, currentIt, iterations, buffer);
+		flushRectangles(currentIt, iterations, buffer);
+		std::swap(buffer.current_, buffer.next_);
+		buffer.next_.clear();
+	}
+
+#ifndef _FIXEDPOINT
+	laneIterations_ += buffer.stats_.iterations_;
+	laneSlots_ += buffer.stats_.slots_;
+#endif
+	filledPixels_ += buffer.filled_;
+	computedPixels_ += buffer.computed_;
+	recordCosts(fromY, toY, buffer.rowIterations_.data());
+}
+
+//the corners of the cell are known. fills the pixels of the cell that aren't known yet if all corners have the same
+//iteration count. otherwise queues the corners of its four quarters.
+void Renderer::refineCell(const Rectangle& cell, const fd_dim_t& sliceY, const fd_iter_count_t& currentIt, fd_iter_count_t* iterations, RectangleBuffer& buffer) {
+	const fd_dim_t width = config_.width_;
+	const fd_dim_t fromX = cell.fromX_;
+	const fd_dim_t toX = cell.toX_ - 1;
+	const fd_dim_t fromY = cell.fromY_;
+	const fd_dim_t toY = cell.toY_ - 1;
+	if (toX - fromX <= 1 && toY - fromY <= 1)
+		return;
+
+	const fd_iter_count_t* top = iterations + (fromY - sliceY) * width;
+	const fd_iter_count_t* bottom = iterations + (toY - sliceY) * width;
+	const fd_iter_count_t value = top[fromX];
+	if (top[toX] == value && bottom[fromX] == value && bottom[toX] == value) {
+		for (fd_dim_t y = fromY; y <= toY; ++y) {
+			fd_iter_count_t* row = iterations + (y - sliceY) * width;
+			uint8_t* known = buffer.known_.data() + (y - sliceY) * width;
+			for (fd_dim_t x = fromX; x <= toX; ++x) {
+				if (!known[x]) {
+					known[x] = 1;
+					row[x] = value;
+					++buffer.filled_;
+				}
+			}
+		}
+		return;
+	}
+
+	//sides that are only two pixels long aren't split
+	const fd_dim_t xs[3] = { fromX, toX - fromX > 1 ? (fromX + toX) / 2 : toX, toX };
+	const fd_dim_t ys[3] = { fromY, toY - fromY > 1 ? (fromY + toY) / 2 : toY, toY };
+	for (size_t j = 0; j < 3; ++j) {
+		for (size_t i = 0; i < 3; ++i)
+			guessPixel(xs[i], ys[j], sliceY, currentIt, iterations, buffer);
+	}
+
+	for (size_t j = 0; j < 2; ++j) {
+		for (size_t i = 0; i < 2; ++i) {
+			if (xs[i] != xs[i + 1] && ys[j] != ys[j + 1])
+				buffer.next_.push_back({xs[i], xs[i + 1] + 1, ys[j], ys[j + 1] + 1});
+		}
+	}
+}
+
+void Renderer::guessPixel(const fd_dim_t& x, const fd_dim_t& y, const fd_dim_t& sliceY, const fd_iter_count_t& currentIt, fd_iter_count_t* iterations, RectangleBuffer& buffer) {
+	const size_t i = (y - sliceY) * config_.width_ + x;
+	if (buffer.known_[i])
+		return;
+
+	buffer.known_[i] = 1;
+	++buffer.computed_;
+	queuePixel(x, y, sliceY, currentIt, iterations, buffer);
+}
+
+//gathers a pixel for the next flushRectangles(). pixels that can be reprojected are copied right away. fixed point
+//builds and precisions beyond double (the gathered coordinates are fd_mandelfloat_t) iterate them right away.
+inline void Renderer::queuePixel(const fd_dim_t& x, const fd_dim_t& y, const fd_dim_t& sliceY, const fd_iter_count_t& currentIt, fd_iter_count_t* iterations, RectangleBuffer& buffer) {
+	const fd_dim_t width = config_.width_;
+#ifndef _FIXEDPOINT
+	if (reproject_ && sourceY_[y] >= 0 && sourceX_[x] >= 0) {
+		iterations[(y - sliceY) * width + x] = previousIterations_[sourceY_[y] * width + sourceX_[x]];
+	} else if (precision_ > PRECISION_DOUBLE) {
+		iterations[(y - sliceY) * width + x] = mandelbrot(x, y, currentIt);
+		buffer.rowIterations_[y - sliceY] += iterations[(y - sliceY) * width + x];
+	} else {
+		buffer.pointr_.push_back(coordinates_.pointr_[x]);
+		buffer.pointi_.push_back(coordinates_.pointi_[y]);
+		buffer.index_.push_back((y - sliceY) * width + x);
+	}
 #else
-inline fd_mandelfloat_t Renderer::square(const fd_mandelfloat_t& n) const {
-	return n * n;
+	iterations[(y - sliceY) * width + x] = mandelbrot(x, y, currentIt);
+	buffer.rowIterations_[y - sliceY] += iterations[(y - sliceY) * width + x];
+#endif
 }
+
+void Renderer::queueRectangle(const fd_dim_t& fromX, const fd_dim_t& toX, const fd_dim_t& fromY, const fd_dim_t& toY, const fd_dim_t& sliceY, const fd_iter_count_t& currentIt, fd_iter_count_t* iterations, RectangleBuffer& buffer) {
+	buffer.computed_ += (toX - fromX) * (toY - fromY);
+	for (fd_dim_t y = fromY; y < toY; ++y) {
+		for (fd_dim_t x = fromX; x < toX; ++x)
+			queuePixel(x, y, sliceY, currentIt, iterations, buffer);
+	}
+}
+
+void Renderer::flushRectangles(const fd_iter_count_t& currentIt, fd_iter_count_t* iterations, RectangleBuffer& buffer) {
+#ifndef _FIXEDPOINT
+	buffer.iterations_.resize(buffer.index_.size());
+	iteratePoints(buffer.pointr_.data(), buffer.pointi_.data(), buffer.index_.size(), currentIt, buffer.iterations_.data(), buffer.stats_);
+	for (size_t i = 0; i < buffer.index_.size(); ++i) {
+		iterations[buffer.index_[i]] = buffer.iterations_[i];
+		buffer.rowIterations_[buffer.index_[i] / config_.width_] += buffer.iterations_[i];
+	}
+
+	buffer.pointr_.clear();
+	buffer.pointi_.clear();
+	buffer.index_.clear();
 #endif
+}
 
-inline fd_iter_count_t Renderer::mandelbrot(const fd_coord_t& x, const fd_coord_t& y, const fd_iter_count_t& currentIt) {
-#if 1
-	fd_iter_count_t iterations = 0;
-	fd_mandelfloat_t x0 = (x + camera_.getOffsetX() + camera_.getPanX()) / (camera_.getZoom() / 10.0);
-	fd_mandelfloat_t y0 = (y + camera_.getOffsetY() + camera_.getPanY()) / (camera_.getZoom() / 10.0);
-
-	fd_mandelfloat_t zr = 0.0, zi = 0.0;
-	fd_mandelfloat_t zrsqr = 0;
-	fd_mandelfloat_t zisqr = 0;
-	fd_bigfloat_t pointr = x0 / config_.width_; //0.0 - 1.0
-	fd_bigfloat_t pointi = y0 / config_.height_; //0.0 - 1.0
-	fd_mandelfloat_t four = 4.0;
-
-	//Algebraically optimized version that uses addition/subtraction as often as possible while reducing multiplications
-	//and limiting multiplications to squaring only. this pretty nicely compiles to asm on Linux x86_64 (+simd), WASM (+simd) and m68k (000/020/030)
-	//because types are chosen very carefully in "types.hpp"
-	while (iterations < currentIt && zrsqr + zisqr <= four) {
-		//zi = (square(zr + zi) - zrsqr) - zisqr; //equals line below as a consequence of binomial expansion
-		zi = (zr + zr) * zi;
-		zi += pointi;
-		zr = (zrsqr - zisqr) + pointr;
-
-		zrsqr = square(zr);
-		zisqr = square(zi);
-
-		++iterations;
-	}
-	return iterations;
-#else
-	float x0 = (x + camera_.getOffsetX() + camera_.getPanX()) / (camera_.getZoom() / 10.0);
-	float y0 = (y + camera_.getOffsetY() + camera_.getPanY()) / (camera_.getZoom() / 10.0);
-	std::complex<float> point(x0/config_.width_, y0/config_.height_);
-	std::complex<float> z(0, 0);
-	fd_iter_count_t iterations = 0;
-	while (abs (z) < 2 && iterations < maxIterations_) {
-		z = z * z + point;
-		++iterations;
+void Renderer::iterateSliceSimd(const fd_dim_t& fromY, const fd_dim_t& toY, const fd_iter_count_t& currentIt, fd_iter_count_t* iterations, LaneStats& stats) {
+	const fd_dim_t width = config_.width_;
+	const fd_dim_t rows = toY - fromY;
+	const fd_mandelfloat_t* pointr = coordinates_.pointr_.data();
+
+	if (config_.kernel_ == KERNEL_SIMD_PERSISTENT) {
+		persistentKernel_(pointr, coordinates_.pointi_.data() + fromY, width, rows, iterations, currentIt, config_.interiorCheck_, config_.formulaParams_, stats);
+	} else {
+		std::vector<fd_mandelfloat_t>& pointi = scratch().pointi_;
+		for (fd_dim_t y = fromY; y < toY; ++y) {
+			std::fill(pointi.begin(), pointi.end(), coordinates_.pointi_[y]);
+			simdKernel_(pointr, pointi.data(), iterations + (y - fromY) * width, width, currentIt, config_.interiorCheck_, config_.formulaParams_, stats);
+		}
 	}
+}
+
+void Renderer::waitForSlices() {
+	frameTasks_.wait();
+}
 
-	return iterations;
+//one set of buffers per worker of the pool as it is sized for the frame and one for the main thread
+void Renderer::prepareScratch() {
+	const size_t size = ThreadPool::size() + 1;
+	if (scratch_.size() == size)
+		return;
+	scratch_.resize(size);
+	for (Scratch& s : scratch_) {
+		s.pointr_.resize(config_.width_);
+		s.pointi_.resize(config_.width_);
+#ifndef _FIXEDPOINT
+		s.missingIterations_.resize(config_.width_);
+		s.missing_.reserve(config_.width_);
 #endif
+	}
 }
 
+//the scratch buffers of the calling thread. the main thread (not a worker) takes the last ones.
+Renderer::Scratch& Renderer::scratch() {
+	return scratch_[std::min(ThreadPool::workerIndex(), scratch_.size() - 1)];
+}
+
+#ifndef _FIXEDPOINT
+//picks the precision of the frame from its pixel spacing
+void Renderer::preparePrecision() {
+	precision_ = config_.precision_;
+	if (config_.autoPrecision_) {
+		const std::vector<fd_mandelfloat_t>& pointr = coordinates_.pointr_;
+		const std::vector<fd_mandelfloat_t>& pointi = coordinates_.pointi_;
+		const fd_mandelfloat_t step = std::min(pointr[1] - pointr[0], pointi[1] - pointi[0]);
+		const fd_mandelfloat_t extent = std::max(std::max(fd_abs(pointr.front()), fd_abs(pointr.back())), std::max(fd_abs(pointi.front()), fd_abs(pointi.back())));
+		precision_ = select_precision(step, extent, config_.precisionGuardBits_);
+	}
+
+	simdKernel_ = select_simd_kernel(config_.simdLevel_, config_.simdLanes_, precision_, config_.formula_);
+	persistentKernel_ = select_persistent_kernel(config_.simdLevel_, config_.simdLanes_, precision_, config_.formula_);
+	pointKernel_ = select_point_kernel(precision_, config_.formula_);
+}
+
+void Renderer::prepareReprojection() {
+	const fd_iter_count_t currentIt = frameIterations_;
+
+	previousIterations_.swap(iterations_);
+
+	//the previous frame is useless if it was calculated with a different iteration count or precision. beyond double
+	//the coordinates can't be matched. the distance field isn't kept for the previous frame.
+	reproject_ = reprojection_ && !perturbate_ && !distance_ && frameNumber_ > 0 && previousIt_ == currentIt && precision_ == previousPrecision_ && precision_ <= PRECISION_DOUBLE;
+	if (reproject_) {
+		reprojectAxis(previousCoordinates_.pointr_, previousCoordinates_.bigPointr_, coordinates_.pointr_, coordinates_.bigPointr_, sourceX_);
+		reprojectAxis(previousCoordinates_.pointi_, previousCoordinates_.bigPointi_, coordinates_.pointi_, coordinates_.bigPointi_, sourceY_);
+	}
+
+	previousIt_ = currentIt;
+	previousPrecision_ = precision_;
+	++frameNumber_;
+}
+
+//maps columns (or rows) of the previous frame to columns of the current frame that are at most the configured
+//tolerance (in pixels) away. both are sorted, so a greedy sweep yields the maximum number of reused columns and every
+//column of the previous frame is reused at most once. additionally every n-th column is recalculated (at a different
+//phase every frame) so that every pixel is refreshed at least every n frames and reused coordinates are pulled back
+//onto the grid. a reused column takes over both coordinates of the previous one, so they keep describing the same point.
+void Renderer::reprojectAxis(const std::vector<fd_mandelfloat_t>& previous, const std::vector<fd_bigfloat_t>& bigPrevious, std::vector<fd_mandelfloat_t>& current, std::vector<fd_bigfloat_t>& bigCurrent, std::vector<fd_coord_t>& source) {
+	const size_t size = current.size();
+	const fd_mandelfloat_t step = current[1] - current[0];
+	const fd_mandelfloat_t tolerance = config_.reprojectionTolerance_ * step;
+	const size_t refresh = config_.reprojectionRefresh_;
+	size_t j = 0;
+
+	for (size_t x = 0; x < size; ++x) {
+		source[x] = -1;
+		while (j < previous.size() && previous[j] < current[x] - tolerance)
+			++j;
+
+		if (j < previous.size() && previous[j] <= current[x] + tolerance) {
+			if (refresh == 0 || (x + frameNumber_) % refresh != 0) {
+				source[x] = j;
+				current[x] = previous[j];
+				bigCurrent[x] = bigPrevious[j];
+			}
+			++j;
+		}
+	}
+}
+
+//iterates every pixel of the slice with the distance estimation kernel and converts the distances to pixels
+void Renderer::iterateSliceDistance(const fd_dim_t& fromY, const fd_dim_t& toY, const fd_iter_count_t& currentIt, fd_iter_count_t* iterations) {
+	const fd_dim_t width = config_.width_;
+	const fd_float_t pixel = std::fabs(coordinates_.pointr_[1] - coordinates_.pointr_[0]);
+
+	for (fd_dim_t y = fromY; y < toY; ++y) {
+		fd_float_t* distances = distances_.data() + y * width;
+		for (fd_dim_t x = 0; x < width; ++x) {
+			if (precision_ == PRECISION_FLOAT) {
+				float distance;
+				iterations[(y - fromY) * width + x] = formula_point_distance<float>(config_.formula_, config_.formulaParams_, coordinates_.pointr_[x], coordinates_.pointi_[y], currentIt, config_.interiorCheck_, distance);
+				distances[x] = distance / pixel;
+			} else {
+				fd_mandelfloat_t distance;
+				iterations[(y - fromY) * width + x] = formula_point_distance<fd_mandelfloat_t>(config_.formula_, config_.formulaParams_, coordinates_.pointr_[x], coordinates_.pointi_[y], currentIt, config_.interiorCheck_, distance);
+				distances[x] = distance / pixel;
+			}
+		}
+	}
+}
+
+void Renderer::iterateSliceReprojected(const fd_dim_t& fromY, const fd_dim_t& toY, const fd_iter_count_t& currentIt, fd_iter_count_t* iterations, LaneStats& stats) {
+	const fd_dim_t width = config_.width_;
+	Scratch& s = scratch();
+	std::vector<fd_mandelfloat_t>& pointr = s.pointr_;
+	std::vector<fd_mandelfloat_t>& pointi = s.pointi_;
+	std::vector<fd_iter_count_t>& missingIterations = s.missingIterations_;
+	std::vector<fd_dim_t>& missing = s.missing_;
+
+	for (fd_dim_t y = fromY; y < toY; ++y) {
+		fd_iter_count_t* row = iterations + (y - fromY) * width;
+		const fd_coord_t sourceY = sourceY_[y];
+		std::fill(pointi.begin(), pointi.end(), coordinates_.pointi_[y]);
+
+		if (sourceY < 0) {
+			iteratePoints(coordinates_.pointr_.data(), pointi.data(), width, currentIt, row, stats);
+			continue;
+		}
+
+		//copy what the previous frame has and gather the rest
+		const size_t previousRow = sourceY * width;
+		missing.clear();
+		for (fd_dim_t x = 0; x < width; ++x) {
+			const fd_coord_t sourceX = sourceX_[x];
+			if (sourceX >= 0) {
+				row[x] = previousIterations_[previousRow + sourceX];
+			} else {
+				pointr[missing.size()] = coordinates_.pointr_[x];
+				missing.push_back(x);
+			}
+		}
+
+		iteratePoints(pointr.data(), pointi.data(), missing.size(), currentIt, missingIterations.data(), stats);
+		for (size_t i = 0; i < missing.size(); ++i)
+			row[missing[i]] = missingIterations[i];
+	}
+}
+
+void Renderer::iteratePoints(const fd_mandelfloat_t* pointr, const fd_mandelfloat_t* pointi, const size_t& size, const fd_iter_count_t& currentIt, fd_iter_count_t* iterations, LaneStats& stats) {
+	if (size == 0)
+		return;
+
+	if (config_.kernel_ == KERNEL_SCALAR) {
+		if (precision_ == PRECISION_FLOAT) {
+			for (size_t i = 0; i < size; ++i)
+				iterations[i] = formula_point<float>(config_.formula_, config_.formulaParams_, config_.unroll_, pointr[i], pointi[i], currentIt, config_.interiorCheck_);
+		} else {
+			for (size_t i = 0; i < size; ++i)
+				iterations[i] = formula_point<fd_mandelfloat_t>(config_.formula_, config_.formulaParams_, config_.unroll_, pointr[i], pointi[i], currentIt, config_.interiorCheck_);
+		}
+		return;
+	}
+
+	simdKernel_(pointr, pointi, iterations, size, currentIt, config_.interiorCheck_, config_.formulaParams_, stats);
+}
+#endif
+
+void Renderer::setReprojection(const bool& enabled) {
+#ifndef _FIXEDPOINT
+	reprojection_ = enabled && config_.reprojection_;
+#endif
+}
+
+void Renderer::setSymmetry(const bool& enabled) {
+	symmetry_ = enabled && config_.symmetry_;
+}
+
+bool Renderer::isPerturbating() const {
+#ifndef _FIXEDPOINT
+	return perturbate_;
+#else
+	return false;
+#endif
+}
+
+const fd_float_t* Renderer::getDistances() const {
+#ifndef _FIXEDPOINT
+	return distance_ ? distances_.data() : nullptr;
+#else
+	return nullptr;
+#endif
+}
+
+fd_float_t Renderer::getFillRatio() const {
+	uint64_t total = filledPixels_ + computedPixels_;
+	if (total == 0)
+		return 0;
+	return fd_float_t(filledPixels_) / total;
+}
+
+fd_float_t Renderer::getLaneUtilization() const {
+	uint64_t slots = laneSlots_;
+	if (slots == 0)
+		return 0;
+	return fd_float_t(laneIterations_) / slots;
+}
+
+Renderer::ThreadStats Renderer::getThreadStats() {
+	waitForSlices();
+	ThreadStats stats;
+	fd_highres_tick_t end = frameStart_;
+	for (const fd_highres_tick_t& f : finished_)
+		end = std::max(end, f);
+	const fd_highres_tick_t frame = end - frameStart_;
+	for (const fd_highres_tick_t& b : busy_) {
+		stats.busy_.push_back(b);
+		stats.idle_.push_back(frame - std::min(b, frame));
+	}
+	return stats;
+}
+
+void Renderer::accumulateThreadStats() {
+	fd_highres_tick_t end = frameStart_;
+	for (const fd_highres_tick_t& f : finished_)
+		end = std::max(end, f);
+	for (const fd_highres_tick_t& b : busy_) {
+		threadBusy_ += b;
+		threadTime_ += end - frameStart_;
+	}
+	busy_.clear();
+	finished_.clear();
+}
+
+fd_float_t Renderer::getBusyRatio() const {
+	if (threadTime_ == 0)
+		return 0;
+	return std::min(fd_float_t(threadBusy_) / threadTime_, fd_float_t(1));
+}
+
+void Renderer::resetStats() {
+	laneIterations_ = 0;
+	laneSlots_ = 0;
+	threadBusy_ = 0;
+	threadTime_ = 0;
+	filledPixels_ = 0;
+	computedPixels_ = 0;
+}
+
+inline fd_iter_count_t Renderer::mandelbrot(const fd_coord_t& x, const fd_coord_t& y, const fd_iter_count_t& currentIt) {
+#ifndef _FIXEDPOINT
+	if (precision_ > PRECISION_DOUBLE)
+		return pointKernel_(coordinates_.bigPointr_[x], coordinates_.bigPointi_[y], currentIt, config_.interiorCheck_, config_.formulaParams_);
+	if (precision_ == PRECISION_FLOAT)
+		return formula_point<float>(config_.formula_, config_.formulaParams_, config_.unroll_, coordinates_.pointr_[x], coordinates_.pointi_[y], currentIt, config_.interiorCheck_);
+#endif
+	return formula_point<fd_mandelfloat_t>(config_.formula_, config_.formulaParams_, config_.unroll_, coordinates_.pointr_[x], coordinates_.pointi_[y], currentIt, config_.interiorCheck_);
+}
 
 } /* namespace fractaldive */
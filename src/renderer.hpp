@@ -8,11 +8,18 @@
 #include <vector>
 #include <cstring>
 #include <mutex>
+#include <atomic>
 
 #include "types.hpp"
 #include "threadpool.hpp"
 #include "config.hpp"
 #include "camera.hpp"
+#include "kernel.hpp"
+#include "dispatch.hpp"
+#include "precision.hpp"
+#include "perturbation.hpp"
+#include "iterationbuffer.hpp"
+#include "coordinates.hpp"
 
 namespace fractaldive {
 
@@ -23,9 +30,102 @@ public:
 	const fd_dim_t BUFFERSIZE;
 private:
 	fd_iter_count_t maxIterations_;
+	//simd lane statistics. iterations actually computed vs. lane slots spent
+	std::atomic<uint64_t> laneIterations_;
+	std::atomic<uint64_t> laneSlots_;
+	//pixels filled by RENDER_RECTANGLES/RENDER_GUESSING vs. pixels calculated (or copied from the previous frame)
+	std::atomic<uint64_t> filledPixels_;
+	std::atomic<uint64_t> computedPixels_;
+#ifndef _FIXEDPOINT
+	Perturbation perturbation_;
+	//true if the current frame is rendered by perturbation_
+	std::atomic<bool> perturbate_;
+
+	//XaoS style reprojection: the coordinates of the previous frame and for every column/row the one of the previous
+	//frame it is copied from (-1 if it has to be calculated)
+	Coordinates previousCoordinates_;
+	std::vector<fd_coord_t> sourceX_;
+	std::vector<fd_coord_t> sourceY_;
+	IterationBuffer previousIterations_;
+	fd_iter_count_t previousIt_;
+	size_t frameNumber_;
+	bool reprojection_;
+	//true if the current frame reuses pixels of the previous frame
+	bool reproject_;
+	//distance estimation: the distance of every pixel of the current frame to the boundary of the set in pixels and
+	//whether the current frame has them (see Config::distanceEstimation_)
+	std::vector<fd_float_t> distances_;
+	bool distance_;
+#endif
+	//iteration counts of the current frame and the maximum iteration count it is rendered with. the workers only read
+	//the latter, setMaxIterations() may change maxIterations_ while a frame renders.
+	IterationBuffer iterations_;
+	fd_iter_count_t frameIterations_;
+	//the tasks of the current frame and the slices of it that didn't finish yet. unrenderedSlices_ drops to 0 as soon
+	//as all slices are iterated and colored, frameTasks_ is done once the mirrored rows are done, too.
+	TaskGroup frameTasks_;
+	std::atomic<size_t> unrenderedSlices_;
+	//conjugate symmetry: if the frame contains the real axis, the rows [mirrorFrom_, mirrorTo_) on its shorter side are
+	//copied from the rows mirrorSum_ - y and only the rows [renderFrom_, renderTo_) are calculated
+	bool symmetry_;
+	fd_dim_t renderFrom_;
+	fd_dim_t renderTo_;
+	fd_dim_t mirrorFrom_;
+	fd_dim_t mirrorTo_;
+	fd_coord_t mirrorSum_;
+	//SCHEDULE_STEALING: the rows to calculate are cut into tiles. every worker starts with a contiguous run of them in
+	//its own deque, takes tiles from the front of it and once it runs dry steals from the back of the others.
+	struct TileQueue {
+		std::mutex mutex_;
+		std::deque<std::pair<fd_dim_t, fd_dim_t>> tiles_;
+	};
+	std::vector<TileQueue> tileQueues_;
+	//the cost (see rowCosts_) and busy time of the tiles every worker rendered since the last frame of
+	//SCHEDULE_STEALING and the moving average of its speed from them. with pinned threads the runs are dealt out in
+	//proportion to the speed of the core they run on.
+	std::vector<uint64_t> workerCost_;
+	std::vector<fd_highres_tick_t> workerBusy_;
+	std::vector<fd_float_t> workerSpeed_;
+	//the schedule of the current frame and for SCHEDULE_STRIPES/SCHEDULE_COST the rows of every task
+	Schedule frameSchedule_;
+	std::vector<std::pair<fd_dim_t, fd_dim_t>> regions_;
+	//SCHEDULE_COST (and the worker speeds of SCHEDULE_STEALING): the cost of every row of the last frame, the
+	//iterations of the pixels it calculated plus one per pixel. pixels copied by reprojection or filled by the render
+	//modes cost no iterations. 0 for rows that were never rendered.
+	std::vector<uint64_t> rowCosts_;
+	//when the current frame was dispatched and per task the time it spent rendering and when it was done. accumulated
+	//into threadBusy_/threadTime_ for the benchmark.
+	fd_highres_tick_t frameStart_;
+	std::vector<fd_highres_tick_t> busy_;
+	std::vector<fd_highres_tick_t> finished_;
+	uint64_t threadBusy_;
+	uint64_t threadTime_;
+	//the coordinates of the columns/rows of the current frame
+	Coordinates coordinates_;
+#ifndef _FIXEDPOINT
+	//precision of the current and of the previous frame and the kernels for it
+	Precision precision_;
+	Precision previousPrecision_;
+	simd_kernel_t simdKernel_;
+	persistent_kernel_t persistentKernel_;
+	point_kernel_t pointKernel_;
+#else
+	//the integer simd kernels, nullptr if there are none for the cpu
+	simd_kernel_t simdKernel_;
+	persistent_kernel_t persistentKernel_;
+#endif
+	//the ring of frame buffers: one the next frame is rendered into, the newest complete one, one being drawn and one
+	//per frame rendered ahead (see Config::renderAhead_). the current frame is rendered into imageData_, which is
+	//frames_[rendering_]. published_ is the newest complete frame and holds_ counts how often every buffer is
+	//acquired. neither the published nor an acquired buffer is written to.
+	std::vector<image_t> frames_;
+	std::vector<size_t> holds_;
+	size_t rendering_;
+	size_t published_;
+	std::mutex frameMutex_;
+	image_t imageData_;
 
 public:
-	image_t const imageData_;
 	std::vector<uint32_t> palette_;
 
 	Renderer(Config& config, Camera& camera, const fd_iter_count_t& maxIterations) :
@@ -33,22 +133,115 @@ public:
 			camera_(camera),
 			BUFFERSIZE(config.width_ * config.height_),
 			maxIterations_(maxIterations),
-			imageData_(new fd_image_pix_t[BUFFERSIZE]) {
-		makeNewPalette();
-		memset(imageData_, 0, BUFFERSIZE * sizeof(fd_image_pix_t));
+			laneIterations_(0),
+			laneSlots_(0),
+			filledPixels_(0),
+			computedPixels_(0),
+#ifndef _FIXEDPOINT
+			perturbation_(config.width_, config.height_, config.perturbationReferences_),
+			perturbate_(false),
+			previousCoordinates_(config.width_, config.height_),
+			sourceX_(config.width_, -1),
+			sourceY_(config.height_, -1),
+			previousIterations_(config.width_ * config.height_),
+			previousIt_(0),
+			frameNumber_(0),
+			reprojection_(config.reprojection_),
+			reproject_(false),
+			distance_(false),
+#endif
+			iterations_(config.width_ * config.height_),
+			frameIterations_(maxIterations),
+			unrenderedSlices_(0),
+			symmetry_(config.symmetry_),
+			renderFrom_(0),
+			renderTo_(config.height_),
+			mirrorFrom_(0),
+			mirrorTo_(0),
+			mirrorSum_(0),
+			frameSchedule_(SCHEDULE_STRIPES),
+			rowCosts_(config.height_, 0),
+			frameStart_(0),
+			threadBusy_(0),
+			threadTime_(0),
+			coordinates_(config.width_, config.height_),
+#ifndef _FIXEDPOINT
+			precision_(PRECISION_DOUBLE),
+			previousPrecision_(PRECISION_DOUBLE),
+			simdKernel_(select_simd_kernel(config.simdLevel_, config.simdLanes_, precision_, config.formula_)),
+			persistentKernel_(select_persistent_kernel(config.simdLevel_, config.simdLanes_, precision_, config.formula_)),
+			pointKernel_(select_point_kernel(precision_, config.formula_)),
+#else
+			simdKernel_(select_fixed_kernel(config.simdLevel_, config.simdLanes_, config.formula_)),
+			persistentKernel_(select_fixed_persistent_kernel(config.simdLevel_, config.simdLanes_, config.formula_)),
+#endif
+			frames_(config.renderAhead_ + 3),
+			holds_(frames_.size(), 0),
+			rendering_(1),
+			published_(0),
+			imageData_(nullptr) {
+		for (image_t& frame : frames_) {
+			frame = new fd_image_pix_t[BUFFERSIZE];
+			memset(frame, 0, BUFFERSIZE * sizeof(fd_image_pix_t));
+		}
+		imageData_ = frames_[rendering_];
+		palette_ = makePalette();
 	}
 
 	virtual ~Renderer() {
-		delete[] imageData_;
+		for (image_t& frame : frames_)
+			delete[] frame;
 	}
 	inline fd_iter_count_t getCurrentMaxIterations() const;
-	inline fd_mandelfloat_t square(const fd_mandelfloat_t& n) const;
 	inline fd_iter_count_t mandelbrot(const fd_coord_t& x, const fd_coord_t& y, const fd_iter_count_t& currentIt);
 
+	//the image is recolored from the iteration counts, no need to render it again. the workers color with the palette
+	//until the frame is complete.
 	void makeNewPalette() {
+		waitForSlices();
 		palette_ = makePalette();
+		colorize();
 	}
+
+	const IterationBuffer& getIterations() const {
+		return iterations_;
+	}
+	//hands the newest complete frame to the canvas or to the queue of frames rendered ahead. it isn't written to until
+	//it is released, rendering goes on into the other buffers. a frame is published as soon as its last task returned.
+	const fd_image_pix_t* acquireFrame();
+	void releaseFrame(const fd_image_pix_t* frame);
+	//true once the frame started by the last call to render() is complete
+	bool isFrameDone();
+	//waits for that frame for at most millis milliseconds. returns true if it is complete.
+	bool waitForFrame(const fd_highres_tick_t& millis);
 	void render();
+	bool isPerturbating() const;
+	//the distance field of the last frame: the estimated distance of every pixel to the boundary of the set in pixels,
+	//0 inside of the set. nullptr if the frame has none.
+	const fd_float_t* getDistances() const;
+#ifndef _FIXEDPOINT
+	Precision getPrecision() const {
+		return precision_;
+	}
+#endif
+	//enables/disables reusing pixels of the previous frame. e.g. the benchmark needs every frame fully rendered.
+	void setReprojection(const bool& enabled);
+	//enables/disables mirroring rows across the real axis. the benchmark disables it for the same reason.
+	void setSymmetry(const bool& enabled);
+	void renderSlice(const fd_dim_t& fromY, const fd_dim_t& toY);
+	//colors the whole image from the iteration counts of the last frame
+	void colorize();
+	fd_float_t getLaneUtilization() const;
+	//the time the workers spent rendering vs. the time from dispatching the frames to their last worker being done
+	fd_float_t getBusyRatio() const;
+	//busy and idle time of every worker task of the last frame in ticks of get_highres_tick(). waits for the frame.
+	struct ThreadStats {
+		std::vector<fd_highres_tick_t> busy_;
+		std::vector<fd_highres_tick_t> idle_;
+	};
+	ThreadStats getThreadStats();
+	fd_float_t getFillRatio() const;
+	void resetStats();
 	void zoomAt(const fd_coord_t& x, const fd_coord_t& y, const fd_float_t& factor, const bool& zoomin);
 	void resetSmoothPan();
 	void initSmoothPan(const fd_coord_t& x, const fd_coord_t& y);
@@ -63,6 +256,108 @@ public:
 	}
 
 private:
+	struct Rectangle {
+		fd_dim_t fromX_;
+		fd_dim_t toX_;
+		fd_dim_t fromY_;
+		fd_dim_t toY_;
+	};
+
+	//per slice state of RENDER_RECTANGLES/RENDER_GUESSING. the rectangles of one level of subdivision are processed
+	//together and the pixels they need are gathered so they can be iterated in one batch.
+	struct RectangleBuffer {
+		std::vector<Rectangle> current_;
+		std::vector<Rectangle> next_;
+		//RENDER_GUESSING: pixels that are calculated, queued or filled
+		std::vector<uint8_t> known_;
+#ifndef _FIXEDPOINT
+		std::vector<fd_mandelfloat_t> pointr_;
+		std::vector<fd_mandelfloat_t> pointi_;
+		std::vector<fd_iter_count_t> iterations_;
+		std::vector<fd_dim_t> index_;
+		LaneStats stats_;
+#endif
+		uint64_t filled_ = 0;
+		uint64_t computed_ = 0;
+		//the iterations of the pixels calculated per row of the slice (see rowCosts_)
+		std::vector<uint64_t> rowIterations_;
+
+		//empties the buffer for a slice of the given number of rows, keeping the capacity
+		void reset(const fd_dim_t& rows) {
+			current_.clear();
+			next_.clear();
+			known_.clear();
+#ifndef _FIXEDPOINT
+			pointr_.clear();
+			pointi_.clear();
+			iterations_.clear();
+			index_.clear();
+			stats_ = LaneStats();
+#endif
+			filled_ = 0;
+			computed_ = 0;
+			rowIterations_.assign(rows, 0);
+		}
+	};
+
+	//the buffers a slice is rendered with, one per worker and one for the main thread, so rendering a slice doesn't
+	//allocate. the row buffers are sized when the pool changes, the others grow to the largest slice.
+	struct Scratch {
+		std::vector<fd_iter_count_t> iterations_;
+		RectangleBuffer rectangles_;
+		//iterateSliceSimd()/iterateSliceReprojected(): the coordinates of the pixels of a row to calculate
+		std::vector<fd_mandelfloat_t> pointr_;
+		std::vector<fd_mandelfloat_t> pointi_;
+#ifndef _FIXEDPOINT
+		std::vector<fd_iter_count_t> missingIterations_;
+		std::vector<fd_dim_t> missing_;
+		Perturbation::Scratch perturbation_;
+#endif
+	};
+	std::vector<Scratch> scratch_;
+
+	void prepareScratch();
+	Scratch& scratch();
+
+	void iterateSliceRectangles(const fd_dim_t& fromY, const fd_dim_t& toY, const fd_iter_count_t& currentIt, fd_iter_count_t* iterations);
+	void subdivideRectangle(const Rectangle& rect, const fd_dim_t& sliceY, const fd_iter_count_t& currentIt, fd_iter_count_t* iterations, RectangleBuffer& buffer);
+	void iterateSliceGuessing(const fd_dim_t& fromY, const fd_dim_t& toY, const fd_iter_count_t& currentIt, fd_iter_count_t* iterations);
+	void refineCell(const Rectangle& cell, const fd_dim_t& sliceY, const fd_iter_count_t& currentIt, fd_iter_count_t* iterations, RectangleBuffer& buffer);
+	void guessPixel(const fd_dim_t& x, const fd_dim_t& y, const fd_dim_t& sliceY, const fd_iter_count_t& currentIt, fd_iter_count_t* iterations, RectangleBuffer& buffer);
+	inline void queuePixel(const fd_dim_t& x, const fd_dim_t& y, const fd_dim_t& sliceY, const fd_iter_count_t& currentIt, fd_iter_count_t* iterations, RectangleBuffer& buffer);
+	void queueRectangle(const fd_dim_t& fromX, const fd_dim_t& toX, const fd_dim_t& fromY, const fd_dim_t& toY, const fd_dim_t& sliceY, const fd_iter_count_t& currentIt, fd_iter_count_t* iterations, RectangleBuffer& buffer);
+	void flushRectangles(const fd_iter_count_t& currentIt, fd_iter_count_t* iterations, RectangleBuffer& buffer);
+	void iterateSlice(const fd_dim_t& fromY, const fd_dim_t& toY, const fd_iter_count_t& currentIt, fd_iter_count_t* iterations);
+	bool subdivides() const;
+	void recordCosts(const fd_dim_t& fromY, const fd_dim_t& toY, const uint64_t* rowIterations);
+	void colorSlice(const fd_dim_t& fromY, const fd_dim_t& toY);
+	template<typename T>
+	void colorRows(const T* iterations, const fd_dim_t& fromY, const fd_dim_t& toY);
+	void waitForSlices();
+	void selectBuffer();
+	void publish();
+	size_t scheduleStripes();
+	size_t scheduleTiles();
+	size_t scheduleCost();
+	fd_dim_t tileRows() const;
+	void updateWorkerSpeeds();
+	static void runTask(void* renderer, size_t task);
+	void renderRegion(const size_t& task);
+	void renderTiles(const size_t& task);
+	bool takeTile(const size_t& worker, std::pair<fd_dim_t, fd_dim_t>& tile);
+	void accumulateThreadStats();
+	void prepareSymmetry();
+	void finishSlice();
+	void mirrorRows();
+#ifndef _FIXEDPOINT
+	void preparePrecision();
+	void prepareReprojection();
+	void reprojectAxis(const std::vector<fd_mandelfloat_t>& previous, const std::vector<fd_bigfloat_t>& bigPrevious, std::vector<fd_mandelfloat_t>& current, std::vector<fd_bigfloat_t>& bigCurrent, std::vector<fd_coord_t>& source);
+	void iterateSliceDistance(const fd_dim_t& fromY, const fd_dim_t& toY, const fd_iter_count_t& currentIt, fd_iter_count_t* iterations);
+	void iterateSliceReprojected(const fd_dim_t& fromY, const fd_dim_t& toY, const fd_iter_count_t& currentIt, fd_iter_count_t* iterations, LaneStats& stats);
+	void iteratePoints(const fd_mandelfloat_t* pointr, const fd_mandelfloat_t* pointi, const size_t& size, const fd_iter_count_t& currentIt, fd_iter_count_t* iterations, LaneStats& stats);
+#endif
+	void iterateSliceSimd(const fd_dim_t& fromY, const fd_dim_t& toY, const fd_iter_count_t& currentIt, fd_iter_count_t* iterations, LaneStats& stats);
 	std::pair<fd_coord_t, fd_coord_t> smoothPan(const fd_coord_t& x, const fd_coord_t& y);
 };
 } /* namespace fractaldive */
@@ -4,5 +4,7 @@ namespace fractaldive {
 ThreadPool* ThreadPool::instance_ = nullptr;
 #ifndef _NO_THREADS
 std::mutex ThreadPool::instanceMtx_;
+size_t ThreadPool::size_ = 0;
+thread_local size_t ThreadPool::workerIndex_ = SIZE_MAX;
 #endif
 } /* namespace fractaldive */
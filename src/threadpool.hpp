@@ -8,22 +8,93 @@
 #endif
 
 #include <vector>
-#include <queue>
-#include <memory>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #ifndef _NO_THREADS
 #include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <climits>
 #endif
-#include <future>
-#include <functional>
 #include <stdexcept>
 
+#include "topology.hpp"
+
+#if !defined(_NO_THREADS) && defined(__linux__) && !defined(_JAVASCRIPT)
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#define FD_FUTEX
+#define FD_AFFINITY
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 namespace fractaldive {
 
+//a task is a plain function called with a context and an index, so it fits a fixed slot without allocating
+typedef void (*task_function_t)(void* context, size_t index);
+
+//what idle workers do
+enum WaitPolicy {
+	//sleep on a condition variable right away
+	WAIT_PARK,
+	//spin for a while, so a dispatch that follows closely doesn't have to wake them, then sleep (on a futex on linux)
+	WAIT_SPIN
+};
+
 #ifndef _NO_THREADS
+//a latch over the tasks enqueued with it. wait() returns once all of them returned, not just once they were taken
+//off the queue.
+class TaskGroup {
+public:
+	TaskGroup() :
+			pending_(0) {
+	}
+
+	void add(const size_t& tasks) {
+		std::unique_lock<std::mutex> lock(mutex_);
+		pending_ += tasks;
+	}
+
+	//the waiter can't return before the lock is released, so the group isn't touched after it might be destroyed
+	void done() {
+		std::unique_lock<std::mutex> lock(mutex_);
+		if (--pending_ == 0)
+			condition_.notify_all();
+	}
+
+	void wait() {
+		std::unique_lock<std::mutex> lock(mutex_);
+		condition_.wait(lock, [this] {return this->pending_ == 0;});
+	}
+
+	//waits for at most "micros" microseconds. returns true if the group is done.
+	bool waitFor(const size_t& micros) {
+		std::unique_lock<std::mutex> lock(mutex_);
+		return condition_.wait_for(lock, std::chrono::microseconds(micros), [this] {return this->pending_ == 0;});
+	}
+
+	bool isDone() {
+		std::unique_lock<std::mutex> lock(mutex_);
+		return pending_ == 0;
+	}
+
+private:
+	size_t pending_;
+	std::mutex mutex_;
+	std::condition_variable condition_;
+};
+
 class ThreadPool {
 public:
+	//the number of task slots. enqueueing into a full queue waits for a free slot.
+	static constexpr size_t SLOTS = 1024;
+
+	//the cpus the process can keep busy, which in a container with a cpu quota are fewer than the cores of the host
 	static size_t cores() {
 		size_t numThreads = 0;
 #ifdef _JAVASCRIPT
@@ -32,19 +103,33 @@ public:
 		numThreads = emscripten_num_logical_cores();
 #endif
 #else
-		numThreads = std::thread::hardware_concurrency();
+		numThreads = available_cpus();
+		if (numThreads == 0)
+			numThreads = std::thread::hardware_concurrency();
 #endif
 		return numThreads;
 	}
 
 	static size_t size() {
-		return getInstance().workers_.size();
+		return getInstance().active_;
+	}
+
+	//the number of workers of the instance. has to be called before it is created, 0 means cores().
+	static void setSize(const size_t& threads) {
+		std::unique_lock<std::mutex> lock(instanceMtx_);
+		assert(instance_ == nullptr);
+		size_ = threads;
+	}
+
+	//the index of the worker the calling thread is, SIZE_MAX for threads that aren't workers of a pool
+	static size_t workerIndex() {
+		return workerIndex_;
 	}
 
 	static ThreadPool& getInstance() {
 		std::unique_lock<std::mutex> lock(instanceMtx_);
 		if (instance_ == nullptr) {
-			instance_ = new ThreadPool(ThreadPool::cores());
+			instance_ = new ThreadPool(size_ > 0 ? size_ : ThreadPool::cores());
 		}
 
 		return *instance_;
@@ -52,47 +137,87 @@ public:
 
 	// the constructor just launches some amount of workers
 	inline ThreadPool(size_t threads) :
-			stop_(false) {
-		for (size_t i = 0; i < threads; ++i)
-			workers_.emplace_back([this]
-			{
-				for(;;)
-				{
-					std::function<void()> task;
-
-					{
-						std::unique_lock<std::mutex> lock(this->queue_mutex_);
-						this->condition_.wait(lock,
-								[this] {return this->stop_ || !this->tasks_.empty();});
-						if(this->stop_ && this->tasks_.empty())
-						return;
-
-						std::unique_lock<std::mutex> lock2(this->join_mutex_);
-						task = std::move(this->tasks_.front());
-						this->tasks_.pop();
-						if(this->tasks_.empty())
-							joinCondition_.notify_all();
-					}
-
-					task();
-				}
-			});
+			slots_(SLOTS), head_(0), count_(0), running_(0), active_(0), waitPolicy_(WAIT_PARK), spinMicros_(0), epoch_(0), sleepers_(0), stop_(false) {
+		resize(threads);
 	}
 
-	// add new work item to the pool
-	template<class F, class ... Args>
-	void enqueue(F&& f, Args&&... args) {
-		auto task = std::make_shared<std::function<void()>>(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+	//starts or retires workers until there are "threads" of them. retired workers finish the task they run. the
+	//pool keeps running, but the indices of the workers change, so it shouldn't be called while tasks are queued
+	//that depend on the number of workers.
+	void resize(size_t threads) {
+		threads = std::max<size_t>(threads, 1);
+		std::unique_lock<std::mutex> lock(queue_mutex_);
+		if (stop_ || threads == workers_.size())
+			return;
+		if (threads > workers_.size()) {
+			for (size_t i = workers_.size(); i < threads; ++i) {
+				workers_.emplace_back([this, i] {this->work(i);});
+				pinWorker(i);
+			}
+			active_ = threads;
+			return;
+		}
 
+		active_ = threads;
+		lock.unlock();
+		wake(workers_.size());
+		for (size_t i = threads; i < workers_.size(); ++i)
+			workers_[i].join();
+		lock.lock();
+		workers_.resize(threads);
+	}
+
+	//runs function(context, i) for every i in [begin, end) as tasks of group. context has to stay valid until the
+	//group is done.
+	void parallel_for(TaskGroup& group, const size_t& begin, const size_t& end, task_function_t function, void* context) {
+		if (begin >= end)
+			return;
+
+		group.add(end - begin);
 		{
 			std::unique_lock<std::mutex> lock(queue_mutex_);
 
 			// don't allow enqueueing after stopping the pool
 			assert(!stop_);
 
-			tasks_.emplace([task]() {(*task)();});
+			for (size_t i = begin; i < end; ++i) {
+				if (count_ == SLOTS) {
+					//workers sleeping on the futex have to be woken, too
+					wake(count_);
+					spaceCondition_.wait(lock, [this] {return this->count_ < SLOTS;});
+				}
+				Task& task = slots_[(head_ + count_) % SLOTS];
+				task.function_ = function;
+				task.context_ = context;
+				task.index_ = i;
+				task.group_ = &group;
+				++count_;
+			}
 		}
-		condition_.notify_one();
+		wake(end - begin);
+	}
+
+	//the same for a functor called with the index, which has to stay valid until the group is done
+	template<typename F>
+	void parallel_for(TaskGroup& group, const size_t& begin, const size_t& end, F& f) {
+		parallel_for(group, begin, end, [](void* context, size_t index) {(*static_cast<F*>(context))(index);}, &f);
+	}
+
+	//pins worker i to cpus[i % cpus.size()], workers started later, too. returns false if that isn't supported or the
+	//os refused.
+	bool pin(const std::vector<int>& cpus) {
+#ifdef FD_AFFINITY
+		if (cpus.empty())
+			return false;
+		std::unique_lock<std::mutex> lock(queue_mutex_);
+		pins_ = cpus;
+		bool pinned = true;
+		for (size_t i = 0; i < workers_.size(); ++i)
+			pinned = pinWorker(i) && pinned;
+		return pinned;
+#else
+		return false;
+#endif
 	}
 
 	// the destructor joins all threads
@@ -100,17 +225,24 @@ public:
 		stop();
 	}
 
+	//spinMicros: how long WAIT_SPIN spins before the worker sleeps
+	void setWaitPolicy(const WaitPolicy& policy, const size_t& spinMicros) {
+		spinMicros_ = spinMicros;
+		waitPolicy_ = policy;
+	}
+
 	size_t taskCount() {
 		std::unique_lock<std::mutex> lock(queue_mutex_);
-		return tasks_.size();
+		return count_;
 	}
 
+	//waits until every task enqueued so far returned
 	void join() {
-		std::unique_lock<std::mutex> lock(this->join_mutex_);
-		if(!this->tasks_.empty())
-			joinCondition_.wait(lock);
+		std::unique_lock<std::mutex> lock(queue_mutex_);
+		joinCondition_.wait(lock, [this] {return this->count_ == 0 && this->running_ == 0;});
 	}
 
+	//the queued tasks are run before the workers return
 	void stop() {
 		{
 			std::unique_lock<std::mutex> lock(queue_mutex_);
@@ -118,27 +250,174 @@ public:
 				return;
 			stop_ = true;
 		}
-		condition_.notify_all();
-		this->join();
+		wake(workers_.size());
+		for (std::thread& worker : workers_) {
+			if (worker.joinable() && worker.get_id() != std::this_thread::get_id())
+				worker.join();
+		}
 	}
 
 private:
+	struct Task {
+		task_function_t function_ = nullptr;
+		void* context_ = nullptr;
+		size_t index_ = 0;
+		TaskGroup* group_ = nullptr;
+	};
+
+	static void relax() {
+#if defined(__x86_64__) || defined(__i386__)
+		__builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+		asm volatile("yield");
+#endif
+	}
+
+	void work(const size_t& index) {
+		workerIndex_ = index;
+		for (;;) {
+			Task task;
+			if (!take(task, index))
+				return;
+			spaceCondition_.notify_one();
+
+			task.function_(task.context_, task.index_);
+			if (task.group_ != nullptr)
+				task.group_->done();
+
+			{
+				std::unique_lock<std::mutex> lock(queue_mutex_);
+				--running_;
+				if (count_ == 0 && running_ == 0)
+					joinCondition_.notify_all();
+			}
+		}
+	}
+
+	bool pinWorker(const size_t& index) {
+#ifdef FD_AFFINITY
+		if (pins_.empty())
+			return true;
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(pins_[index % pins_.size()], &set);
+		return pthread_setaffinity_np(workers_[index].native_handle(), sizeof(set), &set) == 0;
+#else
+		return false;
+#endif
+	}
+
+	//spins until there is a task, the pool is stopped, the worker is retired or spinMicros_ passed. yields every now
+	//and then, in case there are more threads than cores.
+	void spin(const size_t& index) {
+		const auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(spinMicros_);
+		for (size_t i = 1; count_ == 0 && !stop_ && index < active_; ++i) {
+			relax();
+			if ((i % 64) == 0) {
+				if (std::chrono::steady_clock::now() >= until)
+					return;
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	//takes the next task off the queue and waits for one according to the wait policy. returns false once the pool
+	//is stopped and the queue is drained or once the worker is retired.
+	bool take(Task& task, const size_t& index) {
+		if (waitPolicy_ == WAIT_SPIN)
+			spin(index);
+
+		std::unique_lock<std::mutex> lock(queue_mutex_);
+		for (;;) {
+			if (index >= active_)
+				return false;
+			if (count_ > 0) {
+				task = slots_[head_];
+				head_ = (head_ + 1) % SLOTS;
+				--count_;
+				++running_;
+				return true;
+			}
+			if (stop_)
+				return false;
+#ifdef FD_FUTEX
+			if (waitPolicy_ == WAIT_SPIN) {
+				//the queue is empty under the lock, so a dispatch that follows changes the epoch after it. either the
+				//futex sees the change or the dispatch sees the sleeper.
+				++sleepers_;
+				const uint32_t epoch = epoch_;
+				lock.unlock();
+				syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch_), FUTEX_WAIT_PRIVATE, epoch, nullptr, nullptr, 0);
+				--sleepers_;
+				lock.lock();
+				continue;
+			}
+#endif
+			condition_.wait(lock);
+		}
+	}
+
+	//wakes up to "tasks" sleeping workers with a single call per dispatch
+	void wake(const size_t& tasks) {
+		++epoch_;
+#ifdef FD_FUTEX
+		if (sleepers_ > 0)
+			syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch_), FUTEX_WAKE_PRIVATE, int(std::min<size_t>(tasks, INT_MAX)), nullptr, nullptr, 0);
+#endif
+		condition_.notify_all();
+	}
+
 	// need to keep track of threads so we can join them
 	std::vector<std::thread> workers_;
-	// the task queue
-	std::queue<std::function<void()> > tasks_;
+	// the task queue: a ring of count_ tasks starting at head_ and the number of tasks being run. count_ is only
+	// changed under the lock but spinning workers poll it without.
+	std::vector<Task> slots_;
+	size_t head_;
+	std::atomic<size_t> count_;
+	size_t running_;
+	//the number of workers that aren't retired, workers_ has the retired ones until they are joined
+	std::atomic<size_t> active_;
+	//the cpus set by pin()
+	std::vector<int> pins_;
+	std::atomic<WaitPolicy> waitPolicy_;
+	std::atomic<size_t> spinMicros_;
+	//incremented by every dispatch, sleeping WAIT_SPIN workers wait for it to change
+	std::atomic<uint32_t> epoch_;
+	std::atomic<size_t> sleepers_;
 
 	// synchronization
 	std::mutex queue_mutex_;
-	std::mutex join_mutex_;
 	std::condition_variable condition_;
+	std::condition_variable spaceCondition_;
 	std::condition_variable joinCondition_;
 
-	bool stop_;
+	std::atomic<bool> stop_;
 	static ThreadPool* instance_;
 	static std::mutex instanceMtx_;
+	static size_t size_;
+	static thread_local size_t workerIndex_;
 };
 #else
+class TaskGroup {
+public:
+	void add(const size_t& tasks) {
+	}
+
+	void done() {
+	}
+
+	void wait() {
+	}
+
+	bool waitFor(const size_t& micros) {
+		return true;
+	}
+
+	bool isDone() {
+		return true;
+	}
+};
+
 class ThreadPool {
 public:
 	static size_t cores() {
@@ -149,6 +428,13 @@ public:
 		return 0;
 	}
 
+	static void setSize(const size_t& threads) {
+	}
+
+	static size_t workerIndex() {
+		return SIZE_MAX;
+	}
+
 	static ThreadPool& getInstance() {
 		if (instance_ == nullptr) {
 			instance_ = new ThreadPool(0);
@@ -163,10 +449,30 @@ public:
 	inline ~ThreadPool() {
 	}
 
-	// add new work item to the pool
-	template<class F, class ... Args>
-	void enqueue(F&& f, Args&&... args) {
+	//without threads the tasks are run right away
+	void parallel_for(TaskGroup& group, const size_t& begin, const size_t& end, task_function_t function, void* context) {
+		for (size_t i = begin; i < end; ++i)
+			function(context, i);
+	}
+
+	template<typename F>
+	void parallel_for(TaskGroup& group, const size_t& begin, const size_t& end, F& f) {
+		for (size_t i = begin; i < end; ++i)
+			f(i);
+	}
+
+	void setWaitPolicy(const WaitPolicy& policy, const size_t& spinMicros) {
+	}
 
+	void resize(size_t threads) {
+	}
+
+	bool pin(const std::vector<int>& cpus) {
+		return false;
+	}
+
+	size_t taskCount() {
+		return 0;
 	}
 
 	void join() {
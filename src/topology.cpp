@@ -0,0 +1,172 @@
+#include "topology.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <fstream>
+
+#if defined(__linux__) && !defined(_JAVASCRIPT)
+#include <sched.h>
+#endif
+
+namespace fractaldive {
+
+const char* pin_policy_name(const PinPolicy& policy) {
+	switch (policy) {
+	case PIN_COMPACT:
+		return "compact";
+	case PIN_SCATTER:
+		return "scatter";
+	case PIN_PHYSICAL:
+		return "physical";
+	default:
+		return "none";
+	}
+}
+
+bool parse_pin_policy(const char* name, PinPolicy& policy) {
+	const PinPolicy policies[] = { PIN_NONE, PIN_COMPACT, PIN_SCATTER, PIN_PHYSICAL };
+	for (const PinPolicy& p : policies) {
+		if (std::strcmp(name, pin_policy_name(p)) == 0) {
+			policy = p;
+			return true;
+		}
+	}
+	return false;
+}
+
+#if defined(__linux__) && !defined(_JAVASCRIPT)
+static bool read_id(const int& cpu, const char* file, int& id) {
+	char path[128];
+	snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/%s", cpu, file);
+	FILE* f = fopen(path, "r");
+	if (f == nullptr)
+		return false;
+	const bool ok = fscanf(f, "%d", &id) == 1;
+	fclose(f);
+	return ok;
+}
+
+std::vector<Cpu> read_topology() {
+	std::vector<Cpu> cpus;
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	if (sched_getaffinity(0, sizeof(set), &set) != 0)
+		return cpus;
+
+	for (int id = 0; id < CPU_SETSIZE; ++id) {
+		if (!CPU_ISSET(id, &set))
+			continue;
+		Cpu cpu = { id, 0, id };
+		//without a topology every cpu counts as a core of its own
+		if (!read_id(id, "physical_package_id", cpu.package_) || !read_id(id, "core_id", cpu.core_)) {
+			cpu.package_ = 0;
+			cpu.core_ = id;
+		}
+		cpus.push_back(cpu);
+	}
+	return cpus;
+}
+//the cpu quota as a number of cpus, rounded up. 0 if there is none. controllers are looked up in the cgroup of the
+//process and in the root of the hierarchy, which is what a container sees of its own cgroup.
+static size_t quota_cpus() {
+	std::ifstream cgroups("/proc/self/cgroup");
+	std::string line;
+	while (std::getline(cgroups, line)) {
+		//hierarchy-id:controllers:path
+		const size_t first = line.find(':');
+		const size_t second = line.find(':', first + 1);
+		if (first == std::string::npos || second == std::string::npos)
+			continue;
+		const std::string controllers = "," + line.substr(first + 1, second - first - 1) + ",";
+		const std::string path = line.substr(second + 1);
+		const std::string dirs[] = { path, "/" };
+		for (const std::string& dir : dirs) {
+			long long quota = -1;
+			long long period = 0;
+			if (controllers == ",,") {
+				//v2: "max 100000" or "<quota> <period>"
+				std::ifstream max("/sys/fs/cgroup" + dir + "/cpu.max");
+				std::string q;
+				if (!(max >> q >> period))
+					continue;
+				if (q != "max")
+					quota = std::strtoll(q.c_str(), nullptr, 10);
+			} else if (controllers.find(",cpu,") != std::string::npos) {
+				const std::string base = "/sys/fs/cgroup/" + controllers.substr(1, controllers.size() - 2) + dir;
+				std::ifstream q(base + "/cpu.cfs_quota_us");
+				std::ifstream p(base + "/cpu.cfs_period_us");
+				if (!(q >> quota) || !(p >> period))
+					continue;
+			} else {
+				break;
+			}
+			if (quota > 0 && period > 0)
+				return std::max<long long>((quota + period - 1) / period, 1);
+			break;
+		}
+	}
+	return 0;
+}
+
+size_t available_cpus() {
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	size_t cpus = 0;
+	if (sched_getaffinity(0, sizeof(set), &set) == 0)
+		cpus = CPU_COUNT(&set);
+	const size_t quota = quota_cpus();
+	if (quota > 0 && (cpus == 0 || quota < cpus))
+		cpus = quota;
+	return cpus;
+}
+#else
+std::vector<Cpu> read_topology() {
+	return std::vector<Cpu>();
+}
+
+size_t available_cpus() {
+	return 0;
+}
+#endif
+
+std::vector<int> pin_order(const std::vector<Cpu>& cpus, const PinPolicy& policy) {
+	std::vector<int> order;
+	if (policy == PIN_NONE)
+		return order;
+
+	//the hardware threads of every core, the cores sorted by package and core id
+	std::map<std::pair<int, int>, std::vector<int>> cores;
+	for (const Cpu& cpu : cpus)
+		cores[{cpu.package_, cpu.core_}].push_back(cpu.id_);
+
+	if (policy == PIN_COMPACT) {
+		for (const auto& core : cores)
+			order.insert(order.end(), core.second.begin(), core.second.end());
+	} else if (policy == PIN_PHYSICAL) {
+		for (const auto& core : cores)
+			order.push_back(core.second.front());
+	} else {
+		//round robin over the packages for every rank of core and of hardware thread
+		std::map<int, std::vector<const std::vector<int>*>> packages;
+		for (const auto& core : cores)
+			packages[core.first.first].push_back(&core.second);
+		for (size_t thread = 0; order.size() < cpus.size(); ++thread) {
+			size_t maxCores = 0;
+			for (const auto& package : packages)
+				maxCores = std::max(maxCores, package.second.size());
+			for (size_t rank = 0; rank < maxCores; ++rank) {
+				for (const auto& package : packages) {
+					if (rank < package.second.size() && thread < package.second[rank]->size())
+						order.push_back((*package.second[rank])[thread]);
+				}
+			}
+		}
+	}
+	return order;
+}
+
+} /* namespace fractaldive */
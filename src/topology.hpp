@@ -0,0 +1,44 @@
+#ifndef SRC_TOPOLOGY_HPP_
+#define SRC_TOPOLOGY_HPP_
+
+#include <cstddef>
+#include <vector>
+
+namespace fractaldive {
+
+//which cpus the workers of the thread pool are pinned to
+enum PinPolicy {
+	//don't pin, the scheduler moves the workers around
+	PIN_NONE,
+	//fill the hardware threads of a core, then the cores of a package, then the next package
+	PIN_COMPACT,
+	//spread over the packages first, then over their cores, hardware threads of a core come last
+	PIN_SCATTER,
+	//one worker per physical core, the other hardware threads of a core stay idle
+	PIN_PHYSICAL
+};
+
+const char* pin_policy_name(const PinPolicy& policy);
+//parses a name as returned by pin_policy_name(). returns false for unknown names.
+bool parse_pin_policy(const char* name, PinPolicy& policy);
+
+//a cpu the process may run on and where it sits in the topology
+struct Cpu {
+	int id_;
+	int package_;
+	int core_;
+};
+
+//the cpus of the affinity mask of the process, read from /sys/devices/system/cpu. empty where that isn't available
+//(anything but linux).
+std::vector<Cpu> read_topology();
+//the number of cpus the process can keep busy: those of its affinity mask, limited by the cpu quota of its cgroup
+//(v1 or v2) rounded up. changes when the quota or the mask do (e.g. docker update --cpus). 0 where that isn't
+//available.
+size_t available_cpus();
+//the cpus to pin the workers to in the order of the policy, one worker per entry. empty for PIN_NONE.
+std::vector<int> pin_order(const std::vector<Cpu>& cpus, const PinPolicy& policy);
+
+} /* namespace fractaldive */
+
+#endif /* SRC_TOPOLOGY_HPP_ */
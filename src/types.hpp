@@ -8,6 +8,10 @@
 #include "MFixedPoint/FpF.hpp"
 #endif
 
+#ifdef __SIZEOF_INT128__
+#include "MFixedPoint/FpM.hpp"
+#endif
+
 #ifndef _AMIGA
 #include <chrono>
 #endif
@@ -41,7 +45,20 @@ namespace fractaldive {
 #endif
 
 #ifdef _FIXEDPOINT
-	#ifdef _AMIGA
+	#if defined(_FIXEDPOINT_LIMBS)
+	//multi-limb fixed point for deep zooms, selected with FIXEDPOINT_LIMBS=2|3|4
+	typedef mn::MFixedPoint::FpM8<_FIXEDPOINT_LIMBS> fd_bigfloat_t;
+	typedef mn::MFixedPoint::FpM8<_FIXEDPOINT_LIMBS> fd_mandelfloat_t;
+		#if _FIXEDPOINT_LIMBS == 2
+	constexpr char FD_PRECISION[] = "8bit/120bit";
+		#elif _FIXEDPOINT_LIMBS == 3
+	constexpr char FD_PRECISION[] = "8bit/184bit";
+		#elif _FIXEDPOINT_LIMBS == 4
+	constexpr char FD_PRECISION[] = "8bit/248bit";
+		#else
+		#error _FIXEDPOINT_LIMBS must be 2, 3 or 4
+		#endif
+	#elif defined(_AMIGA)
   	typedef mn::MFixedPoint::FpF16<8> fd_bigfloat_t;
 	typedef mn::MFixedPoint::FpF16<8> fd_mandelfloat_t;
 	constexpr char FD_PRECISION[] = "8bit/8bit";